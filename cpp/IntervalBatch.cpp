@@ -0,0 +1,47 @@
+#include "IntervalBatch.h"
+#include <algorithm>
+#include <iostream>
+
+using namespace std;
+
+IntervalBatch::IntervalBatch(const vector<Interval>& intervals, const AlignmentStore& store)
+    : intervals(intervals)
+    , store(store)
+{
+  build_regions();
+}
+
+void IntervalBatch::build_regions()
+{
+  regions.clear();
+
+  // Sort intervals by contig and start, ties keep their input order
+  vector<pair<uint32_t, size_t>> sorted;
+  sorted.reserve(intervals.size());
+  for (size_t i = 0; i < intervals.size(); ++i) {
+    sorted.push_back({ static_cast<uint32_t>(store.get_contig_index(intervals[i].contig)), i });
+  }
+  std::stable_sort(sorted.begin(), sorted.end(),
+      [this](const pair<uint32_t, size_t>& a, const pair<uint32_t, size_t>& b) {
+        if (a.first != b.first) {
+          return a.first < b.first;
+        }
+        return intervals[a.second].start < intervals[b.second].start;
+      });
+
+  // Merge overlapping or adjacent intervals into regions
+  for (const auto& entry : sorted) {
+    uint32_t contig_index = entry.first;
+    const Interval& interval = intervals[entry.second];
+    uint32_t end = std::max(interval.start, interval.end); // treat inverted intervals as empty
+
+    if (regions.empty() || regions.back().contig_index != contig_index || interval.start > regions.back().end) {
+      regions.push_back({ contig_index, interval.start, end, {} });
+    } else {
+      regions.back().end = std::max(regions.back().end, end);
+    }
+    regions.back().interval_indices.push_back(entry.second);
+  }
+
+  cout << "merged " << intervals.size() << " intervals into " << regions.size() << " regions" << endl;
+}
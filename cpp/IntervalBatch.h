@@ -0,0 +1,85 @@
+#ifndef INTERVALBATCH_H
+#define INTERVALBATCH_H
+
+#include "alignment_store.h"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// A maximal run of overlapping or adjacent query intervals on one contig.
+// Alignments are looked up once per region, no matter how many of the input
+// intervals cover them.
+struct BatchRegion {
+  uint32_t contig_index;
+  uint32_t start;
+  uint32_t end; // exclusive
+  // Input intervals merged into this region, sorted by start
+  std::vector<size_t> interval_indices;
+};
+
+// Executes a set of query intervals in a single sweep: intervals are sorted
+// per contig and merged into regions, each region is scanned once, and each
+// alignment is attributed to every input interval it overlaps.
+class IntervalBatch {
+  private:
+  const std::vector<Interval>& intervals;
+  const AlignmentStore& store;
+  std::vector<BatchRegion> regions;
+
+  void build_regions();
+
+  public:
+  IntervalBatch(const std::vector<Interval>& intervals, const AlignmentStore& store);
+
+  // Merged regions, sorted by contig index and start
+  const std::vector<BatchRegion>& get_regions() const { return regions; }
+
+  // Calls visit(region, alignment) for each alignment overlapping each region
+  template <typename Visitor>
+  void for_each_region_alignment(Visitor&& visit) const
+  {
+    for (const auto& region : regions) {
+      store.for_each_alignment_in_interval(region.contig_index, region.start, region.end,
+          [&](const Alignment& aln) { visit(region, aln); });
+    }
+  }
+
+  // Calls visit(interval_index, alignment) for each input interval and each
+  // alignment overlapping it. Alignments are streamed in order of their start,
+  // so each interval sees its alignments in order of start.
+  template <typename Visitor>
+  void for_each_interval_alignment(Visitor&& visit) const
+  {
+    std::vector<size_t> active;
+    for (const auto& region : regions) {
+      const auto& indices = region.interval_indices;
+      active.clear();
+      size_t next = 0;
+
+      store.for_each_alignment_in_interval(region.contig_index, region.start, region.end, [&](const Alignment& aln) {
+        // admit intervals that start before this alignment
+        while (next < indices.size() && intervals[indices[next]].start <= aln.contig_start) {
+          active.push_back(indices[next]);
+          next++;
+        }
+
+        // retire intervals that end before this alignment, later alignments start further right
+        active.erase(std::remove_if(active.begin(), active.end(),
+                         [&](size_t i) { return intervals[i].end < aln.contig_start; }),
+            active.end());
+
+        // every remaining active interval overlaps the alignment
+        for (size_t interval_index : active) {
+          visit(interval_index, aln);
+        }
+
+        // as do the intervals that start within the alignment
+        for (size_t j = next; j < indices.size() && intervals[indices[j]].start <= aln.contig_end; ++j) {
+          visit(indices[j], aln);
+        }
+      });
+    }
+  }
+};
+
+#endif // INTERVALBATCH_H
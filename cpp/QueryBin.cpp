@@ -1,9 +1,13 @@
 #include "QueryBin.h"
+#include "IntervalBatch.h"
+#include "thread_pool.h"
 #include <algorithm> // For std::min/max
 #include <cassert>
+#include <cmath>
+#include <deque>
 #include <fstream>
+#include <iterator>
 #include <iostream>
-#include <map>
 #include <string>
 #include <vector>
 
@@ -12,113 +16,362 @@ using namespace std;
 QueryBin::QueryBin(
     const std::vector<Interval>& intervals,
     const AlignmentStore& store,
-    int binsize)
+    int binsize,
+    int zoom_min_binsize,
+    int hll_precision,
+    int window,
+    int step)
     : intervals(intervals)
     , store(store)
     , binsize(binsize)
+    , window(window)
+    , step(step)
+    , use_zoom(false)
+    , hll_precision(hll_precision)
 {
-  if (binsize <= 0) {
-    cerr << "error: binsize must be positive." << endl;
-    exit(1);
+  // Throw rather than exit, the R interface passes these straight from its arguments
+  massert(hll_precision == 0 || (hll_precision >= HyperLogLog::MIN_PRECISION && hll_precision <= HyperLogLog::MAX_PRECISION),
+      "hll_precision must be 0 or between %d and %d", HyperLogLog::MIN_PRECISION, HyperLogLog::MAX_PRECISION);
+  massert(zoom_min_binsize >= 0, "zoom_min_binsize must not be negative");
+  massert(window >= 0, "window must not be negative");
+
+  if (window > 0) {
+    // Sliding windows are summed from segments between window boundaries
+    massert(step > 0, "step must be positive for sliding windows");
+    massert(hll_precision == 0, "distinct read sketches are not supported for sliding windows");
+  } else {
+    massert(step == 0, "step requires a positive window");
+    massert(binsize > 0, "binsize must be positive");
+    this->window = binsize;
+    this->step = binsize;
   }
+
+  // Smaller bins rarely hold a whole zoom bin, the raw path alone is cheaper
+  use_zoom = this->window >= zoom_min_binsize;
 }
 
-void QueryBin::aggregate_data()
+// Add the statistics of a zoom bin of level_binsize bp to a dense bin
+static void add_zoom_bin(BinData& bin, const ZoomBin& zoom_bin, uint64_t level_binsize)
 {
-  bin_results.clear();
+  bin.positions += level_binsize;
+  bin.sequenced_basepairs += zoom_bin.sequenced_bases;
+  bin.depth_sum_squares += zoom_bin.depth_sum_squares;
+  bin.min_depth = std::min(bin.min_depth, zoom_bin.min_depth);
+  bin.max_depth = std::max(bin.max_depth, zoom_bin.max_depth);
+  bin.alignment_starts += zoom_bin.alignment_starts;
+  for (size_t t = 0; t < MUTATION_TYPE_COUNT; ++t) {
+    bin.mutation_counts[t] += zoom_bin.mutation_counts[t];
+  }
+}
 
-  for (const auto& interval : intervals) {
-    uint32_t contig_index = store.get_contig_index(interval.contig);
+// Add the statistics of [start, end) on a contig to the dense bins of a
+// layout. The part of the range in each bin is split into the largest
+// aligned zoom bins that fit, coarse levels in the middle and finer ones
+// towards its ends, so a bin takes at most two zoom bins per level. The
+// unaligned edges of the bins are summed from the coverage track and mutation table.
+void QueryBin::add_range(uint32_t contig_index, uint32_t start, uint32_t end, const BinLayout& layout, std::vector<BinData>& bins) const
+{
+  if (!use_zoom || start >= end) {
+    add_raw_range(contig_index, start, end, layout, bins);
+    return;
+  }
+
+  // The truncated last zoom bin of the contig is left to the raw path
+  uint64_t zoom_limit = std::min(uint64_t(end), uint64_t(store.get_contig_length(contig_index) / ZOOM_BASE_BINSIZE) * ZOOM_BASE_BINSIZE);
+  size_t num_levels = store.get_zoom_level_count(contig_index);
 
-    // Calculate relevant bin range based on original interval
-    uint32_t adjusted_start = (interval.start / binsize) * binsize;
-    // Handle edge case where end is 0 or interval is empty
-    if (interval.end == 0 || interval.start >= interval.end)
+  // Raw gaps between zoom bins are summed in one pass, whatever bins they span
+  uint64_t raw_start = start;
+  for (size_t bin = layout.bin_of(start); bin < layout.num_bins && layout.bin_start(bin) < zoom_limit; ++bin) {
+    uint64_t pos = std::max(uint64_t(start), layout.bin_start(bin));
+    pos = (pos + ZOOM_BASE_BINSIZE - 1) / ZOOM_BASE_BINSIZE * ZOOM_BASE_BINSIZE;
+    uint64_t zoom_end = std::min(zoom_limit, layout.bin_end(bin)) / ZOOM_BASE_BINSIZE * ZOOM_BASE_BINSIZE;
+    if (pos >= zoom_end) {
       continue;
-    uint32_t last_bin_start = ((interval.end - 1) / binsize) * binsize;
+    }
+    add_raw_range(contig_index, raw_start, pos, layout, bins);
+    while (pos < zoom_end) {
+      size_t level = 0;
+      while (level + 1 < num_levels) {
+        uint64_t coarser_binsize = uint64_t(ZOOM_BASE_BINSIZE) << (level + 1);
+        if (pos % coarser_binsize != 0 || pos + coarser_binsize > zoom_end) {
+          break;
+        }
+        level++;
+      }
+      uint64_t level_binsize = uint64_t(ZOOM_BASE_BINSIZE) << level;
+      add_zoom_bin(bins[bin], store.get_zoom_bin(contig_index, level, pos / level_binsize), level_binsize);
+      pos += level_binsize;
+    }
+    raw_start = zoom_end;
+  }
+  add_raw_range(contig_index, raw_start, end, layout, bins);
+}
 
-    // Initialize Relevant Bins in the map
-    for (uint32_t b_start = adjusted_start; b_start <= last_bin_start; b_start += binsize) {
-      bin_results.try_emplace({ contig_index, b_start }, BinData());
+// Add the statistics of [start, end) on a contig to dense bins from the
+// coverage track, the overlap index and the mutation table. Coverage runs,
+// alignment starts and mutations are each visited once, a run adds its
+// bases bin by bin, so the cost is linear in runs, starts, mutations and bins.
+void QueryBin::add_raw_range(uint32_t contig_index, uint32_t start, uint32_t end, const BinLayout& layout, std::vector<BinData>& bins) const
+{
+  if (start >= end) {
+    return;
+  }
+  store.for_each_coverage_run(contig_index, start, end, [&](uint32_t run_start, uint32_t run_end, uint32_t depth) {
+    size_t bin_index = layout.bin_of(run_start);
+    for (uint32_t pos = run_start; pos < run_end; ++bin_index) {
+      BinData& bin = bins[bin_index];
+      uint32_t bin_end = std::min(layout.bin_end(bin_index), uint64_t(run_end));
+      uint64_t run_length = bin_end - pos;
+      bin.positions += run_length;
+      bin.sequenced_basepairs += depth * run_length;
+      bin.depth_sum_squares += uint64_t(depth) * depth * run_length;
+      bin.min_depth = std::min(bin.min_depth, depth);
+      bin.max_depth = std::max(bin.max_depth, depth);
+      pos = bin_end;
     }
+  });
 
-    // Get alignments overlapping the *original* interval
-    std::vector<std::reference_wrapper<const Alignment>> alignments = store.get_alignments_in_interval(interval);
+  store.for_each_alignment_starting_in(contig_index, start, end, [&](const Alignment& alignment) {
+    bins[layout.bin_of(alignment.contig_start)].alignment_starts++;
+  });
 
-    for (const auto& alignment_ref : alignments) {
-      const auto& aln = alignment_ref.get();
+  // Mutations are counted once per alignment carrying them
+  store.for_each_mutation_in_interval(contig_index, start, end, [&](uint32_t mutation_index, const Mutation& mutation) {
+    bins[layout.bin_of(mutation.position)].mutation_counts[size_t(mutation.type)] += store.get_mutation_support(contig_index, mutation_index);
+  });
+}
 
-      // Iterate through the relevant bins for this interval
-      for (uint32_t b_start = adjusted_start; b_start <= last_bin_start; b_start += binsize) {
-        uint32_t b_end = b_start + binsize;
+// Add the read of each alignment overlapping [start, end) on a contig to the
+// sketches of the bins of a layout it overlaps within the range
+void QueryBin::add_read_sketches(uint32_t contig_index, uint32_t start, uint32_t end, const BinLayout& layout, std::vector<HyperLogLog>& sketches) const
+{
+  if (start >= end) {
+    return;
+  }
+  store.for_each_alignment_in_interval(contig_index, start, end - 1, [&](const Alignment& alignment) {
+    uint32_t overlap_start = std::max(alignment.contig_start, start);
+    uint32_t overlap_end = std::min(alignment.contig_end, end);
+    if (overlap_start >= overlap_end) {
+      return;
+    }
+    size_t last_bin = layout.bin_of(overlap_end - 1);
+    for (size_t bin = layout.bin_of(overlap_start); bin <= last_bin; ++bin) {
+      sketches[bin].add(alignment.read_index);
+    }
+  });
+}
+
+// Aggregate disjoint, sorted [start, end) ranges of a contig into the bins or
+// windows first_window .. first_window + num_windows - 1, and append their output rows
+void QueryBin::aggregate_ranges(uint32_t contig_index, const std::vector<std::pair<uint32_t, uint32_t>>& ranges,
+    size_t first_window, size_t num_windows, std::vector<BinOutputRow>& rows) const
+{
+  BinLayout layout;
+  layout.start = first_window * step;
+  if (window == binsize && step == binsize) {
+    layout.binsize = binsize;
+    layout.num_bins = num_windows;
+  } else {
+    // Boundaries are the window starts and ends, two sorted sequences
+    std::vector<uint32_t> starts(num_windows);
+    std::vector<uint32_t> ends(num_windows);
+    for (size_t w = 0; w < num_windows; ++w) {
+      starts[w] = layout.start + w * step;
+      ends[w] = starts[w] + window;
+    }
+    layout.boundaries.resize(2 * num_windows);
+    std::merge(starts.begin(), starts.end(), ends.begin(), ends.end(), layout.boundaries.begin());
+    layout.boundaries.erase(std::unique(layout.boundaries.begin(), layout.boundaries.end()), layout.boundaries.end());
+    layout.num_bins = layout.boundaries.size() - 1;
+  }
 
-        // Calculate overlap considering alignment, bin, AND original interval boundaries
-        uint32_t effective_start = std::max({ aln.contig_start, b_start, interval.start });
-        uint32_t effective_end = std::min({ aln.contig_end, b_end, interval.end });
+  // With a step longer than the window, ranges can reach into the gaps
+  // before the first and after the last window, which no bin holds
+  std::vector<std::pair<uint32_t, uint32_t>> clipped;
+  uint64_t span_end = layout.end();
+  for (const auto& range : ranges) {
+    uint32_t start = std::max(range.first, layout.start);
+    uint32_t end = std::min(uint64_t(range.second), span_end);
+    if (start < end) {
+      clipped.emplace_back(start, end);
+    }
+  }
 
-        int overlap_length = (effective_end > effective_start) ? (effective_end - effective_start) : 0;
+  std::vector<BinData> bins(layout.num_bins);
+  for (const auto& range : clipped) {
+    add_range(contig_index, range.first, range.second, layout, bins);
+  }
 
-        if (overlap_length > 0) {
-          auto it = bin_results.find({ contig_index, b_start });
-          // We should always find it because we pre-populated
-          if (it != bin_results.end()) {
-            // Using int now, check potential overflow? (unlikely for overlap_length)
-            it->second.sequenced_basepairs += overlap_length;
-          } else {
-            // This case indicates a logic error in initialization or calculation
-            cerr << "error: bin " << b_start << " on contig " << interval.contig
-                 << " should have been initialized but wasn't." << endl;
-          }
-        }
-      }
+  // Sketches cost 2^hll_precision bytes per bin, only allocated on request
+  std::vector<HyperLogLog> sketches;
+  if (hll_precision > 0) {
+    sketches.assign(layout.num_bins, HyperLogLog(hll_precision));
+    for (const auto& range : clipped) {
+      add_read_sketches(contig_index, range.first, range.second, layout, sketches);
+    }
+  }
 
-      // Process mutations
-      for (uint32_t mutation_index : aln.mutations) { // Iterate indices
-        // Fetch the mutation object
-        const Mutation& mutation = store.get_mutation(aln.contig_index, mutation_index);
+  if (layout.binsize > 0) {
+    append_bin_rows(contig_index, layout, bins, sketches, rows);
+  } else {
+    append_window_rows(contig_index, layout, bins, num_windows, rows);
+  }
+}
 
-        // Position is now absolute contig coordinate
-        uint32_t mutation_contig_pos = mutation.position;
+// Output row of a bin or window of length bp starting at start
+BinOutputRow QueryBin::make_output_row(const string& contig_id, uint32_t start, const BinData& data, uint64_t distinct_reads) const
+{
+  // Population mean and variance of the depth over the queried positions
+  double mean_depth = 0;
+  double depth_variance = 0;
+  if (data.positions > 0) {
+    mean_depth = double(data.sequenced_basepairs) / data.positions;
+    depth_variance = std::max(double(data.depth_sum_squares) / data.positions - mean_depth * mean_depth, 0.0);
+  }
 
-        // Ignore mutations outside the original interval
-        if (mutation_contig_pos < interval.start || mutation_contig_pos >= interval.end) {
-          continue;
-        }
+  const auto& counts = data.mutation_counts;
+  uint64_t substitution_count = counts[size_t(MutationType::SUBSTITUTION)];
+  uint64_t insertion_count = counts[size_t(MutationType::INSERTION)];
+  uint64_t deletion_count = counts[size_t(MutationType::DELETION)];
+  return { contig_id, start, start + window, window,
+    data.sequenced_basepairs, substitution_count + insertion_count + deletion_count,
+    data.positions > 0 ? data.min_depth : 0, data.max_depth, mean_depth, depth_variance,
+    data.alignment_starts, substitution_count, insertion_count, deletion_count, distinct_reads };
+}
 
-        uint32_t mutation_bin_start = (mutation_contig_pos / binsize) * binsize;
-
-        // Find the bin in our map (it must be relevant if pos is within interval)
-        auto it = bin_results.find({ contig_index, mutation_bin_start });
-        if (it != bin_results.end()) {
-          it->second.mutation_count++;
-        } else {
-          // Logic error if mutation is inside interval but bin wasn't initialized.
-          // Could happen if interval.end=0 edge case calculation was wrong.
-          cerr << "error: bin " << mutation_bin_start << " on contig " << interval.contig
-               << " should have been initialized but wasn't." << endl;
-        }
+// Append one output row per uniform bin of a layout
+void QueryBin::append_bin_rows(uint32_t contig_index, const BinLayout& layout, const std::vector<BinData>& bins,
+    const std::vector<HyperLogLog>& sketches, std::vector<BinOutputRow>& rows) const
+{
+  string contig_id = store.get_contig_id(contig_index);
+  for (size_t bin = 0; bin < bins.size(); ++bin) {
+    uint64_t distinct_reads = sketches.empty() ? 0 : uint64_t(std::llround(sketches[bin].estimate()));
+    rows.push_back(make_output_row(contig_id, layout.start + bin * layout.binsize, bins[bin], distinct_reads));
+  }
+}
+
+// Add the additive statistics of a bin to a running total
+static void add_bin_sums(BinData& total, const BinData& data)
+{
+  total.positions += data.positions;
+  total.sequenced_basepairs += data.sequenced_basepairs;
+  total.depth_sum_squares += data.depth_sum_squares;
+  total.alignment_starts += data.alignment_starts;
+  for (size_t t = 0; t < MUTATION_TYPE_COUNT; ++t) {
+    total.mutation_counts[t] += data.mutation_counts[t];
+  }
+}
+
+// Append one output row per sliding window, from the segments of a layout;
+// window w starts at layout.start + w * step. Sums are differences of prefix
+// sums and depth extremes come from monotonic queues, so the cost is linear
+// in windows whatever the overlap.
+void QueryBin::append_window_rows(uint32_t contig_index, const BinLayout& layout, const std::vector<BinData>& bins,
+    size_t num_windows, std::vector<BinOutputRow>& rows) const
+{
+  std::vector<BinData> prefix(bins.size() + 1);
+  for (size_t i = 0; i < bins.size(); ++i) {
+    prefix[i + 1] = prefix[i];
+    add_bin_sums(prefix[i + 1], bins[i]);
+  }
+
+  // Segments of the current window, by increasing min and decreasing max depth
+  std::deque<size_t> min_queue;
+  std::deque<size_t> max_queue;
+  size_t next_bin = 0;
+
+  // Window starts and ends both increase, so their segment boundaries are
+  // found by advancing through the boundaries
+  const auto& boundaries = layout.boundaries;
+  size_t begin = 0;
+  size_t end = 0;
+
+  string contig_id = store.get_contig_id(contig_index);
+  for (size_t w = 0; w < num_windows; ++w) {
+    uint64_t window_start = layout.start + uint64_t(w) * step;
+    while (boundaries[begin] < window_start) {
+      begin++;
+    }
+    while (boundaries[end] < window_start + window) {
+      end++;
+    }
+    for (; next_bin < end; ++next_bin) {
+      while (!min_queue.empty() && bins[min_queue.back()].min_depth >= bins[next_bin].min_depth) {
+        min_queue.pop_back();
+      }
+      min_queue.push_back(next_bin);
+      while (!max_queue.empty() && bins[max_queue.back()].max_depth <= bins[next_bin].max_depth) {
+        max_queue.pop_back();
       }
+      max_queue.push_back(next_bin);
     }
+    while (min_queue.front() < begin) {
+      min_queue.pop_front();
+    }
+    while (max_queue.front() < begin) {
+      max_queue.pop_front();
+    }
+
+    BinData data;
+    data.positions = prefix[end].positions - prefix[begin].positions;
+    data.sequenced_basepairs = prefix[end].sequenced_basepairs - prefix[begin].sequenced_basepairs;
+    data.depth_sum_squares = prefix[end].depth_sum_squares - prefix[begin].depth_sum_squares;
+    data.alignment_starts = prefix[end].alignment_starts - prefix[begin].alignment_starts;
+    for (size_t t = 0; t < MUTATION_TYPE_COUNT; ++t) {
+      data.mutation_counts[t] = prefix[end].mutation_counts[t] - prefix[begin].mutation_counts[t];
+    }
+    data.min_depth = bins[min_queue.front()].min_depth;
+    data.max_depth = bins[max_queue.front()].max_depth;
+    rows.push_back(make_output_row(contig_id, window_start, data, 0));
   }
 }
 
-void QueryBin::generate_output_rows()
+void QueryBin::aggregate_data()
 {
   output_rows.clear();
 
-  for (const auto& entry : bin_results) {
-    const auto& key = entry.first;
-    const auto& data = entry.second;
+  // Overlapping intervals are merged, so each alignment is counted once per bin
+  IntervalBatch batch(intervals, store);
+  const auto& regions = batch.get_regions();
 
-    uint32_t contig_index = key.first;
-    uint32_t bin_start = key.second;
-    uint32_t bin_end = bin_start + binsize; // Bin end is standard
-    int bin_length = binsize; // Bin length is standard
+  // Window w spans [w * step, w * step + window), plain bins being windows
+  // with step and window equal to the bin size. First and last window
+  // overlapping [start, end):
+  auto first_window_of = [&](uint32_t start) -> size_t { return start >= uint32_t(window) ? (start - window) / step + 1 : 0; };
+  auto last_window_of = [&](uint32_t end) -> size_t { return (end - 1) / step; };
 
-    string contig_id = store.get_contig_id(contig_index);
+  // Regions are sorted and disjoint. Consecutive regions whose windows touch
+  // share one dense bin array, whose windows are then all reported.
+  std::vector<std::pair<uint32_t, uint32_t>> ranges;
+  for (size_t i = 0; i < regions.size();) {
+    // Handle edge case where region is empty, or lies between two windows
+    if (regions[i].start >= regions[i].end || first_window_of(regions[i].start) > last_window_of(regions[i].end)) {
+      i++;
+      continue;
+    }
+    uint32_t contig_index = regions[i].contig_index;
+    size_t first_window = first_window_of(regions[i].start);
+    size_t last_window = last_window_of(regions[i].end);
+    size_t j = i + 1;
+    for (; j < regions.size() && regions[j].contig_index == contig_index; ++j) {
+      if (regions[j].start >= regions[j].end || first_window_of(regions[j].start) > last_window_of(regions[j].end)) {
+        continue;
+      }
+      if (first_window_of(regions[j].start) > last_window) {
+        break;
+      }
+      last_window = last_window_of(regions[j].end);
+    }
 
-    output_rows.push_back({ contig_id, bin_start, bin_end, bin_length,
-        data.sequenced_basepairs, data.mutation_count });
+    ranges.clear();
+    for (size_t k = i; k < j; ++k) {
+      if (regions[k].start < regions[k].end) {
+        ranges.emplace_back(regions[k].start, regions[k].end);
+      }
+    }
+    aggregate_ranges(contig_index, ranges, first_window, last_window - first_window + 1, output_rows);
+    i = j;
   }
 }
 
@@ -129,14 +382,16 @@ void QueryBin::write_to_csv(const std::string& ofn_prefix)
   cout << "writing bin data rows to " << filename << endl;
   ofstream ofs(filename);
 
-  if (!ofs.is_open()) {
-    // Consider throwing an exception instead of exiting
-    cerr << "error: could not open file " << filename << endl;
-    exit(1);
-  }
+  massert(ofs.is_open(), "could not open file %s", filename.c_str());
 
   // Write header - removed coverage column previously present
-  ofs << "contig\tbin_start\tbin_end\tbin_length\tsequenced_bp\tmutation_count\n";
+  ofs << "contig\tbin_start\tbin_end\tbin_length\tsequenced_bp\tmutation_count"
+      << "\tmin_depth\tmax_depth\tmean_depth\tdepth_variance\talignment_starts"
+      << "\tsubstitution_count\tinsertion_count\tdeletion_count";
+  if (has_distinct_reads()) {
+    ofs << "\tdistinct_reads";
+  }
+  ofs << "\n";
 
   for (const auto& row : output_rows) {
     ofs << row.contig << "\t"
@@ -144,7 +399,19 @@ void QueryBin::write_to_csv(const std::string& ofn_prefix)
         << row.bin_end << "\t"
         << row.bin_length << "\t"
         << row.sequenced_basepairs << "\t"
-        << row.mutation_count << "\n";
+        << row.mutation_count << "\t"
+        << row.min_depth << "\t"
+        << row.max_depth << "\t"
+        << row.mean_depth << "\t"
+        << row.depth_variance << "\t"
+        << row.alignment_starts << "\t"
+        << row.substitution_count << "\t"
+        << row.insertion_count << "\t"
+        << row.deletion_count;
+    if (has_distinct_reads()) {
+      ofs << "\t" << row.distinct_reads;
+    }
+    ofs << "\n";
   }
 
   ofs.close();
@@ -153,5 +420,29 @@ void QueryBin::write_to_csv(const std::string& ofn_prefix)
 void QueryBin::execute()
 {
   aggregate_data();
-  generate_output_rows();
+}
+
+void QueryBin::aggregate_contig(uint32_t contig_index, std::vector<BinOutputRow>& rows) const
+{
+  uint32_t length = store.get_contig_length(contig_index);
+  if (length == 0) {
+    return;
+  }
+  aggregate_ranges(contig_index, { { 0, length } }, 0, (length - 1) / step + 1, rows);
+}
+
+void QueryBin::execute_all_contigs(int num_threads)
+{
+  size_t num_contigs = store.get_contig_count();
+  std::vector<std::vector<BinOutputRow>> contig_rows(num_contigs);
+  parallel_for(num_contigs, num_threads, [&](size_t contig_index) {
+    aggregate_contig(contig_index, contig_rows[contig_index]);
+  });
+
+  // Rows come out in contig index order, as in the interval query
+  output_rows.clear();
+  for (auto& rows : contig_rows) {
+    output_rows.insert(output_rows.end(), std::make_move_iterator(rows.begin()), std::make_move_iterator(rows.end()));
+    std::vector<BinOutputRow>().swap(rows);
+  }
 }
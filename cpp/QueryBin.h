@@ -2,56 +2,158 @@
 #define QUERYBIN_H
 
 #include "alignment_store.h" // Includes aln_types.h indirectly
-#include <map>
+#include "hyperloglog.h"
+#include <algorithm>
+#include <cstdint>
+#include <limits>
 #include <string>
 #include <utility> // For std::pair
 #include <vector>
 
 // Data structure to hold aggregated results for a single bin
 struct BinData {
-  int sequenced_basepairs = 0;
-  int mutation_count = 0;
+  uint64_t positions = 0; // positions of the bin within the query intervals
+  uint64_t sequenced_basepairs = 0;
+  uint64_t depth_sum_squares = 0;
+  uint32_t min_depth = std::numeric_limits<uint32_t>::max();
+  uint32_t max_depth = 0;
+  uint64_t alignment_starts = 0;
+  // Mutations by MutationType, counted once per alignment carrying them
+  uint64_t mutation_counts[MUTATION_TYPE_COUNT] = {};
 };
 
-// Data structure representing a single row in the bin output file
+// Dense bins that a run of windows is summed into. Plain bins are uniform, bin
+// i spanning [start + i * binsize, start + (i + 1) * binsize). Sliding windows
+// are summed into segments split at every window start and end, bin i
+// spanning [boundaries[i], boundaries[i + 1]), so there are at most two bins
+// per window whatever the window and step.
+struct BinLayout {
+  uint32_t start = 0;
+  uint32_t binsize = 0; // 0 for segments
+  size_t num_bins = 0;
+  std::vector<uint32_t> boundaries; // num_bins + 1 segment boundaries, empty for uniform bins
+
+  // bin holding a position within the layout
+  size_t bin_of(uint32_t pos) const
+  {
+    if (binsize > 0) {
+      return (pos - start) / binsize;
+    }
+    return std::upper_bound(boundaries.begin(), boundaries.end(), pos) - boundaries.begin() - 1;
+  }
+
+  // start of a bin
+  uint64_t bin_start(size_t bin) const
+  {
+    return binsize > 0 ? start + uint64_t(bin) * binsize : boundaries[bin];
+  }
+
+  // end of a bin, exclusive
+  uint64_t bin_end(size_t bin) const
+  {
+    return binsize > 0 ? start + uint64_t(bin + 1) * binsize : boundaries[bin + 1];
+  }
+
+  // end of the last bin, exclusive
+  uint64_t end() const { return num_bins == 0 ? start : bin_end(num_bins - 1); }
+};
+
+// Data structure representing a single row in the bin output file. Depth
+// statistics are over the positions of the bin within the query intervals.
 struct BinOutputRow {
   std::string contig;
   uint32_t bin_start;
   uint32_t bin_end;
   int bin_length;
-  int sequenced_basepairs;
-  int mutation_count;
+  uint64_t sequenced_basepairs;
+  uint64_t mutation_count;
+  uint32_t min_depth;
+  uint32_t max_depth;
+  double mean_depth;
+  double depth_variance;
+  uint64_t alignment_starts;
+  uint64_t substitution_count;
+  uint64_t insertion_count;
+  uint64_t deletion_count;
+  uint64_t distinct_reads; // approximate, 0 unless distinct reads are sketched
 };
 
 class QueryBin {
   private:
   const std::vector<Interval>& intervals;
   const AlignmentStore& store;
+  // Size of plain bins, equal to window and step; unused with sliding windows
   int binsize;
+  // Length and step of the reported windows, both equal to binsize for plain bins
+  int window;
+  int step;
+  // Whether whole zoom bins within the query bins are taken from the zoom
+  // pyramid, rather than summed from the coverage track and mutation table
+  bool use_zoom;
+  // Precision of the per-bin distinct read sketches, 0 if not sketched
+  int hll_precision;
 
-  // Use a map to store results, keyed by {contig_index, bin_start}
-  std::map<std::pair<uint32_t, uint32_t>, BinData> bin_results;
   // Vector to store the formatted output rows before writing
   std::vector<BinOutputRow> output_rows;
 
-  // execute the query
+  // aggregate the intervals into dense bins and generate the output rows
   void aggregate_data();
 
-  // generate the output rows
-  void generate_output_rows();
+  // add the sequenced bases and mutations of [start, end) to dense bins
+  void add_range(uint32_t contig_index, uint32_t start, uint32_t end, const BinLayout& layout, std::vector<BinData>& bins) const;
+
+  // same, without using the zoom pyramid
+  void add_raw_range(uint32_t contig_index, uint32_t start, uint32_t end, const BinLayout& layout, std::vector<BinData>& bins) const;
+
+  // add the reads of the alignments overlapping [start, end) to the sketches of dense bins
+  void add_read_sketches(uint32_t contig_index, uint32_t start, uint32_t end, const BinLayout& layout, std::vector<HyperLogLog>& sketches) const;
+
+  // aggregate [start, end) ranges of a contig into a run of windows and append their output rows
+  void aggregate_ranges(uint32_t contig_index, const std::vector<std::pair<uint32_t, uint32_t>>& ranges,
+      size_t first_window, size_t num_windows, std::vector<BinOutputRow>& rows) const;
+
+  // output row of the window starting at start
+  BinOutputRow make_output_row(const std::string& contig_id, uint32_t start, const BinData& data, uint64_t distinct_reads) const;
+
+  // append the output rows of dense bins, sketches are empty if not sketched
+  void append_bin_rows(uint32_t contig_index, const BinLayout& layout, const std::vector<BinData>& bins,
+      const std::vector<HyperLogLog>& sketches, std::vector<BinOutputRow>& rows) const;
+
+  // append the output rows of sliding windows summed from segments
+  void append_window_rows(uint32_t contig_index, const BinLayout& layout, const std::vector<BinData>& bins,
+      size_t num_windows, std::vector<BinOutputRow>& rows) const;
+
+  // aggregate a whole contig into dense bins and append its output rows
+  void aggregate_contig(uint32_t contig_index, std::vector<BinOutputRow>& rows) const;
 
   public:
+  // Bins and windows of at least zoom_min_binsize are answered from the zoom
+  // pyramid of the store, whatever their size and alignment. With a
+  // non-zero hll_precision the distinct reads of each bin are estimated with
+  // a HyperLogLog sketch of 2^hll_precision bytes. With a non-zero window,
+  // binsize is ignored and windows of window bp are reported every step bp.
   QueryBin(
       const std::vector<Interval>& intervals,
       const AlignmentStore& store,
-      int binsize);
+      int binsize,
+      int zoom_min_binsize = ZOOM_BASE_BINSIZE,
+      int hll_precision = 0,
+      int window = 0,
+      int step = 0);
 
   // execute the query
   void execute();
 
+  // execute the query over every contig in full, ignoring the intervals.
+  // Each contig is a single sweep over its alignments, contigs run in parallel.
+  void execute_all_contigs(int num_threads);
+
   // write the output rows to a table
   void write_to_csv(const std::string& ofn_prefix);
 
+  // Whether the output rows hold distinct read estimates
+  bool has_distinct_reads() const { return hll_precision > 0; }
+
   // Getter for R interface
   const std::vector<BinOutputRow>& get_output_rows() const { return output_rows; }
 };
@@ -1,19 +1,129 @@
 #include "QueryFull.h"
+#include "IntervalBatch.h"
 #include "utils.h"
 #include <algorithm>
 #include <cstdint>
 #include <fstream>
+#include <functional> // For std::greater
 #include <iostream>
+#include <limits>
 #include <map>
+#include <queue>
+#include <set>
 #include <string>
 #include <vector>
 
 using namespace std;
 
-QueryFull::QueryFull(const vector<Interval>& intervals, const AlignmentStore& store, HeightStyle height_style)
+const std::vector<FullColumn> FULL_ALIGNMENT_COLUMNS = {
+  FullColumn::ALIGNMENT_INDEX, FullColumn::READ_ID, FullColumn::READ_LENGTH, FullColumn::CONTIG_ID,
+  FullColumn::READ_START, FullColumn::READ_END, FullColumn::CONTIG_START, FullColumn::CONTIG_END,
+  FullColumn::IS_REVERSE, FullColumn::CS_TAG, FullColumn::MUTATION_COUNT, FullColumn::HEIGHT
+};
+
+const std::vector<FullColumn> FULL_MUTATION_COLUMNS = {
+  FullColumn::ALIGNMENT_INDEX, FullColumn::READ_ID, FullColumn::CONTIG_ID,
+  FullColumn::MUTATION_TYPE, FullColumn::MUTATION_POSITION, FullColumn::MUTATION_DESC, FullColumn::HEIGHT
+};
+
+const char* full_column_name(FullColumn column)
+{
+  switch (column) {
+  case FullColumn::ALIGNMENT_INDEX:
+    return "alignment_index";
+  case FullColumn::READ_ID:
+    return "read_id";
+  case FullColumn::READ_LENGTH:
+    return "read_length";
+  case FullColumn::CONTIG_ID:
+    return "contig_id";
+  case FullColumn::READ_START:
+    return "read_start";
+  case FullColumn::READ_END:
+    return "read_end";
+  case FullColumn::CONTIG_START:
+    return "contig_start";
+  case FullColumn::CONTIG_END:
+    return "contig_end";
+  case FullColumn::IS_REVERSE:
+    return "is_reverse";
+  case FullColumn::CS_TAG:
+    return "cs_tag";
+  case FullColumn::MUTATION_COUNT:
+    return "mutation_count";
+  case FullColumn::HEIGHT:
+    return "height";
+  case FullColumn::MUTATION_TYPE:
+    return "mutation_type";
+  case FullColumn::MUTATION_POSITION:
+    return "mutation_position";
+  case FullColumn::MUTATION_DESC:
+    return "mutation_desc";
+  default:
+    return "unknown";
+  }
+}
+
+FullColumns::FullColumns()
+{
+  std::fill(std::begin(selected), std::end(selected), true);
+}
+
+bool FullColumns::parse(const std::string& list, std::string& unknown)
+{
+  if (list == "all") {
+    std::fill(std::begin(selected), std::end(selected), true);
+    return true;
+  }
+
+  std::fill(std::begin(selected), std::end(selected), false);
+  size_t pos = 0;
+  while (pos <= list.size()) {
+    size_t comma = list.find(',', pos);
+    if (comma == std::string::npos) {
+      comma = list.size();
+    }
+    std::string name = list.substr(pos, comma - pos);
+    pos = comma + 1;
+
+    bool found = false;
+    for (int c = 0; c < static_cast<int>(FullColumn::COUNT); ++c) {
+      if (name == full_column_name(static_cast<FullColumn>(c))) {
+        selected[c] = true;
+        found = true;
+        break;
+      }
+    }
+    if (!found) {
+      unknown = name;
+      return false;
+    }
+  }
+  return true;
+}
+
+std::vector<FullColumn> FullColumns::select(const std::vector<FullColumn>& table_columns) const
+{
+  std::vector<FullColumn> result;
+  for (FullColumn column : table_columns) {
+    if (has(column)) {
+      result.push_back(column);
+    }
+  }
+  return result;
+}
+
+bool FullColumns::has_mutation_rows() const
+{
+  return has(FullColumn::MUTATION_TYPE) || has(FullColumn::MUTATION_POSITION) || has(FullColumn::MUTATION_DESC);
+}
+
+QueryFull::QueryFull(const vector<Interval>& intervals, const AlignmentStore& store, HeightStyle height_style,
+    const FullColumns& columns)
     : intervals(intervals)
     , store(store)
     , height_style(height_style)
+    , columns(columns)
 {
 }
 
@@ -22,17 +132,23 @@ void QueryFull::generate_output_data()
   uint64_t current_alignment_index = 0;
   output_alignments.clear();
   output_mutations.clear();
+  bool with_mutations = columns.has_mutation_rows();
 
   cout << "number of intervals: " << intervals.size() << endl;
-  for (const auto& interval : intervals) {
-    std::vector<std::reference_wrapper<const Alignment>> alignments = store.get_alignments_in_interval(interval);
-    cout << "interval: " << interval.to_string() << endl;
+
+  // Collect alignments of all intervals in one sweep, then report them in input order
+  std::vector<std::vector<const Alignment*>> interval_alignments(intervals.size());
+  IntervalBatch batch(intervals, store);
+  batch.for_each_interval_alignment([&](size_t interval_index, const Alignment& aln) {
+    interval_alignments[interval_index].push_back(&aln);
+  });
+
+  for (size_t interval_index = 0; interval_index < intervals.size(); ++interval_index) {
+    const auto& alignments = interval_alignments[interval_index];
+    cout << "interval: " << intervals[interval_index].to_string() << endl;
     cout << "number of alignments: " << alignments.size() << endl;
-    for (const auto& alignment_ref : alignments) {
-      const auto& aln = alignment_ref.get();
-      string read_id = store.get_read_id(aln.read_index);
-      string contig_id = store.get_contig_id(aln.contig_index);
-      string cs_string = generate_cs_tag(aln, store);
+    for (const Alignment* aln_ptr : alignments) {
+      const auto& aln = *aln_ptr;
 
       // Get read length from the store
       uint32_t read_length = store.get_reads()[aln.read_index].length;
@@ -42,31 +158,29 @@ void QueryFull::generate_output_data()
 
       // initialize height to 0, will be set later
       output_alignments.push_back({ current_alignment_index,
-          read_id,
+          aln_ptr,
           static_cast<int>(read_length),
-          contig_id,
           static_cast<int>(aln.read_start),
           static_cast<int>(aln.read_end),
           static_cast<int>(aln.contig_start),
           static_cast<int>(aln.contig_end),
           aln.is_reverse,
-          cs_string,
           num_mutations,
           0 });
 
-      for (uint32_t mutation_index : aln.mutations) { // Iterate indices
-        // Fetch mutation object
-        const Mutation& mutation = store.get_mutation(aln.contig_index, mutation_index);
-
-        // Position is absolute contig coordinate
-        // initialize height to 0, will be set later by alignment height
-        output_mutations.push_back({ current_alignment_index,
-            read_id,
-            contig_id,
-            mutation.type,
-            static_cast<int>(mutation.position),
-            mutation.to_string(),
-            0 });
+      if (with_mutations) {
+        for (uint32_t mutation_index : aln.mutations) { // Iterate indices
+          // Fetch mutation object
+          const Mutation& mutation = store.get_mutation(aln.contig_index, mutation_index);
+
+          // Position is absolute contig coordinate
+          // initialize height to 0, will be set later by alignment height
+          output_mutations.push_back({ current_alignment_index,
+              &mutation,
+              mutation.type,
+              static_cast<int>(mutation.position),
+              0 });
+        }
       }
       current_alignment_index++;
     }
@@ -76,60 +190,152 @@ void QueryFull::generate_output_data()
   calculate_heights();
 }
 
+const std::string& QueryFull::get_read_id(const FullOutputAlignments& aln) const
+{
+  return store.get_read_id(aln.alignment->read_index);
+}
+
+const std::string& QueryFull::get_contig_id(const FullOutputAlignments& aln) const
+{
+  return store.get_contig_id(aln.alignment->contig_index);
+}
+
+std::string QueryFull::get_cs_tag(const FullOutputAlignments& aln) const
+{
+  return generate_cs_tag(*aln.alignment, store);
+}
+
+std::string QueryFull::get_mutation_desc(const FullOutputMutations& mut) const
+{
+  return mut.mutation->to_string();
+}
+
+// write the header line of a table with the given columns
+static void write_header(ostream& os, const std::vector<FullColumn>& table_columns)
+{
+  for (size_t i = 0; i < table_columns.size(); ++i) {
+    os << (i > 0 ? "\t" : "") << full_column_name(table_columns[i]);
+  }
+  os << "\n";
+}
+
 void QueryFull::write_to_csv(const std::string& ofn_prefix)
 {
   // --- Write Alignments ---
-  cout << "writing alignments to " << ofn_prefix + "_alignments.tsv" << endl;
-  ofstream ofs_alignments(ofn_prefix + "_alignments.tsv");
-  if (!ofs_alignments.is_open()) {
-    cerr << "error: could not open file " << ofn_prefix + "_alignments.tsv" << endl;
-    exit(1);
-  }
+  std::vector<FullColumn> aln_columns = columns.select(FULL_ALIGNMENT_COLUMNS);
+  if (!aln_columns.empty()) {
+    cout << "writing alignments to " << ofn_prefix + "_alignments.tsv" << endl;
+    ofstream ofs_alignments(ofn_prefix + "_alignments.tsv");
+    if (!ofs_alignments.is_open()) {
+      cerr << "error: could not open file " << ofn_prefix + "_alignments.tsv" << endl;
+      exit(1);
+    }
+
+    write_header(ofs_alignments, aln_columns);
 
-  // Write header with read_length and height columns
-  ofs_alignments << "alignment_index\tread_id\tread_length\tcontig_id\tread_start\tread_end\tcontig_start\tcontig_end\tis_reverse\tcs_tag\tmutation_count\theight\n";
-
-  // Write data
-  for (const auto& aln_data : output_alignments) {
-    ofs_alignments << aln_data.alignment_index << "\t"
-                   << aln_data.read_id << "\t"
-                   << aln_data.read_length << "\t"
-                   << aln_data.contig_id << "\t"
-                   << aln_data.read_start << "\t"
-                   << aln_data.read_end << "\t"
-                   << aln_data.contig_start << "\t"
-                   << aln_data.contig_end << "\t"
-                   << (aln_data.is_reverse ? "true" : "false") << "\t"
-                   << aln_data.cs_tag << "\t"
-                   << aln_data.num_mutations << "\t"
-                   << aln_data.height << "\n";
+    // Write data, string columns are resolved per row
+    for (const auto& aln_data : output_alignments) {
+      for (size_t i = 0; i < aln_columns.size(); ++i) {
+        if (i > 0) {
+          ofs_alignments << "\t";
+        }
+        switch (aln_columns[i]) {
+        case FullColumn::ALIGNMENT_INDEX:
+          ofs_alignments << aln_data.alignment_index;
+          break;
+        case FullColumn::READ_ID:
+          ofs_alignments << get_read_id(aln_data);
+          break;
+        case FullColumn::READ_LENGTH:
+          ofs_alignments << aln_data.read_length;
+          break;
+        case FullColumn::CONTIG_ID:
+          ofs_alignments << get_contig_id(aln_data);
+          break;
+        case FullColumn::READ_START:
+          ofs_alignments << aln_data.read_start;
+          break;
+        case FullColumn::READ_END:
+          ofs_alignments << aln_data.read_end;
+          break;
+        case FullColumn::CONTIG_START:
+          ofs_alignments << aln_data.contig_start;
+          break;
+        case FullColumn::CONTIG_END:
+          ofs_alignments << aln_data.contig_end;
+          break;
+        case FullColumn::IS_REVERSE:
+          ofs_alignments << (aln_data.is_reverse ? "true" : "false");
+          break;
+        case FullColumn::CS_TAG:
+          ofs_alignments << get_cs_tag(aln_data);
+          break;
+        case FullColumn::MUTATION_COUNT:
+          ofs_alignments << aln_data.num_mutations;
+          break;
+        case FullColumn::HEIGHT:
+          ofs_alignments << aln_data.height;
+          break;
+        default:
+          break;
+        }
+      }
+      ofs_alignments << "\n";
+    }
+    ofs_alignments.close();
+    cout << "wrote " << output_alignments.size() << " alignments to " << ofn_prefix + "_alignments.tsv" << endl;
   }
-  ofs_alignments.close();
-  cout << "wrote " << output_alignments.size() << " alignments to " << ofn_prefix + "_alignments.tsv" << endl;
 
   // --- Write Mutations ---
-  cout << "writing mutations to " << ofn_prefix + "_mutations.tsv" << endl;
-  ofstream ofs_mutations(ofn_prefix + "_mutations.tsv");
-  if (!ofs_mutations.is_open()) {
-    cerr << "error: could not open file " << ofn_prefix + "_mutations.tsv" << endl;
-    exit(1);
-  }
+  if (columns.has_mutation_rows()) {
+    std::vector<FullColumn> mut_columns = columns.select(FULL_MUTATION_COLUMNS);
+    cout << "writing mutations to " << ofn_prefix + "_mutations.tsv" << endl;
+    ofstream ofs_mutations(ofn_prefix + "_mutations.tsv");
+    if (!ofs_mutations.is_open()) {
+      cerr << "error: could not open file " << ofn_prefix + "_mutations.tsv" << endl;
+      exit(1);
+    }
+
+    write_header(ofs_mutations, mut_columns);
 
-  // Write header with added height column
-  ofs_mutations << "alignment_index\tread_id\tcontig_id\tmutation_type\tmutation_position\tmutation_desc\theight\n";
-
-  // Write data
-  for (const auto& mut_data : output_mutations) {
-    ofs_mutations << mut_data.alignment_index << "\t"
-                  << mut_data.read_id << "\t"
-                  << mut_data.contig_id << "\t"
-                  << mut_data.type << "\t"
-                  << mut_data.position << "\t"
-                  << mut_data.desc << "\t"
-                  << mut_data.height << "\n";
+    // Write data
+    for (const auto& mut_data : output_mutations) {
+      const FullOutputAlignments& aln_data = output_alignments[mut_data.alignment_index];
+      for (size_t i = 0; i < mut_columns.size(); ++i) {
+        if (i > 0) {
+          ofs_mutations << "\t";
+        }
+        switch (mut_columns[i]) {
+        case FullColumn::ALIGNMENT_INDEX:
+          ofs_mutations << mut_data.alignment_index;
+          break;
+        case FullColumn::READ_ID:
+          ofs_mutations << get_read_id(aln_data);
+          break;
+        case FullColumn::CONTIG_ID:
+          ofs_mutations << get_contig_id(aln_data);
+          break;
+        case FullColumn::MUTATION_TYPE:
+          ofs_mutations << mut_data.type;
+          break;
+        case FullColumn::MUTATION_POSITION:
+          ofs_mutations << mut_data.position;
+          break;
+        case FullColumn::MUTATION_DESC:
+          ofs_mutations << get_mutation_desc(mut_data);
+          break;
+        case FullColumn::HEIGHT:
+          ofs_mutations << mut_data.height;
+          break;
+        default:
+          break;
+        }
+      }
+      ofs_mutations << "\n";
+    }
+    ofs_mutations.close();
+    cout << "wrote " << output_mutations.size() << " mutations to " << ofn_prefix + "_mutations.tsv" << endl;
   }
-  ofs_mutations.close();
-  cout << "wrote " << output_mutations.size() << " mutations to " << ofn_prefix + "_mutations.tsv" << endl;
 }
 
 void QueryFull::execute()
@@ -145,27 +351,23 @@ void QueryFull::calculate_heights()
     calculate_heights_by_mutations();
   }
 
-  // update heights for mutations based on their alignment heights
-  std::map<uint64_t, int> alignment_heights;
-  for (const auto& aln : output_alignments) {
-    alignment_heights[aln.alignment_index] = aln.height;
-  }
-
+  // update heights for mutations based on their alignment heights, alignment
+  // indices are assigned in order and so are positions in output_alignments
   for (auto& mut : output_mutations) {
-    if (alignment_heights.find(mut.alignment_index) != alignment_heights.end()) {
-      mut.height = alignment_heights[mut.alignment_index];
+    if (mut.alignment_index < output_alignments.size()) {
+      mut.height = output_alignments[mut.alignment_index].height;
     }
   }
 }
 
 void QueryFull::calculate_heights_by_coord()
 {
-  // Group alignments by contig_id
-  std::map<std::string, std::vector<FullOutputAlignments*>> alignments_by_contig;
+  // Group alignments by contig
+  std::map<uint32_t, std::vector<FullOutputAlignments*>> alignments_by_contig;
   cout << "calculating heights by coord, number of alignments: " << output_alignments.size() << endl;
 
   for (auto& aln : output_alignments) {
-    alignments_by_contig[aln.contig_id].push_back(&aln);
+    alignments_by_contig[aln.alignment->contig_index].push_back(&aln);
   }
 
   // Process each contig separately
@@ -179,27 +381,33 @@ void QueryFull::calculate_heights_by_coord()
           return a->contig_start < b->contig_start;
         });
 
-    // Assign heights to avoid overlaps
-    std::vector<int> height_ends; // tracks the end position at each height
+    // Assign each alignment the lowest row that is free at its start.
+    // Occupied rows sit in a min-heap keyed by their end; as alignments come
+    // in order of start, a row whose end is at or before the current start
+    // stays free for all later alignments, so it moves to the set of free rows
+    // once. Each alignment costs O(log h) for h rows.
+    using RowEnd = std::pair<int, int>; // (end position, row)
+    std::priority_queue<RowEnd, std::vector<RowEnd>, std::greater<RowEnd>> occupied_rows;
+    std::set<int> free_rows;
+    int num_rows = 0;
 
     for (auto aln_ptr : alignments) {
-      // Find the lowest available height
-      int height = 0;
-      while (height < static_cast<int>(height_ends.size())) {
-        if (aln_ptr->contig_start >= height_ends[height]) {
-          break;
-        }
-        height++;
+      while (!occupied_rows.empty() && occupied_rows.top().first <= aln_ptr->contig_start) {
+        free_rows.insert(occupied_rows.top().second);
+        occupied_rows.pop();
       }
 
-      // If we need a new height level
-      if (height >= static_cast<int>(height_ends.size())) {
-        height_ends.push_back(0);
+      // Take the lowest free row, or open a new one
+      int height;
+      if (!free_rows.empty()) {
+        height = *free_rows.begin();
+        free_rows.erase(free_rows.begin());
+      } else {
+        height = num_rows++;
       }
 
-      // Assign the height and update the end position
       aln_ptr->height = height;
-      height_ends[height] = aln_ptr->contig_end;
+      occupied_rows.push({ aln_ptr->contig_end, height });
     }
   }
 }
@@ -228,8 +436,11 @@ void QueryFull::calculate_heights_by_mutations()
         return a.second > b.second;
       });
 
-  // Group alignments by contig_id for overlap prevention
-  std::map<std::string, std::vector<std::vector<std::pair<int, int>>>> contig_heights;
+  // Occupied intervals of each row, per contig. A row is an ordered set of
+  // (end, start) pairs: intervals within a row do not overlap, so ordering by
+  // end also orders them by start, and both the overlap check and the insert
+  // cost O(log n) for n intervals in the row.
+  std::map<uint32_t, std::vector<RowIntervals>> contig_heights;
 
   // Assign heights in order of decreasing density while preventing overlaps
   cout << "assigning heights, number of mutation densities: " << alignment_densities.size() << endl;
@@ -238,89 +449,30 @@ void QueryFull::calculate_heights_by_mutations()
     FullOutputAlignments& aln = output_alignments[aln_idx];
 
     // Get or create the heights vector for this contig
-    auto& heights = contig_heights[aln.contig_id];
+    auto& heights = contig_heights[aln.alignment->contig_index];
 
-    // Find the minimum height with no overlap
+    // Find the minimum height with no overlap, or open a new one
     int height = 0;
-    bool overlap = true;
-
-    while (overlap) {
-      // Add a new height level if needed
-      if (height >= static_cast<int>(heights.size())) {
-        heights.push_back(std::vector<std::pair<int, int>>());
-        overlap = false;
-      } else {
-        // Check for overlaps at the current height using binary search
-        const auto& intervals_at_height = heights[height];
-
-        if (intervals_at_height.empty()) {
-          // No intervals at this height yet
-          overlap = false;
-        } else {
-          overlap = has_overlap(intervals_at_height, aln.contig_start, aln.contig_end);
-        }
-      }
-
-      if (overlap) {
-        height++;
-      }
+    while (height < static_cast<int>(heights.size()) && has_overlap(heights[height], aln.contig_start, aln.contig_end)) {
+      height++;
+    }
+    if (height == static_cast<int>(heights.size())) {
+      heights.emplace_back();
     }
 
     // Assign height and add the interval to the height level
     aln.height = height;
-
-    // Add the new interval and maintain sorted order
-    add_sorted_interval(heights[height], aln.contig_start, aln.contig_end);
+    heights[height].insert({ aln.contig_end, aln.contig_start });
   }
 }
 
-// helper to check if a new interval overlaps with any existing intervals using binary search
-bool QueryFull::has_overlap(const std::vector<std::pair<int, int>>& intervals, int start, int end)
+// helper to check if a new interval overlaps with any interval of a row
+bool QueryFull::has_overlap(const RowIntervals& row, int start, int end)
 {
-  if (intervals.empty()) {
-    return false;
-  }
-
-  // Binary search to find the interval with end point just before or at the start of new interval
-  auto comp = [](const std::pair<int, int>& interval, int value) {
-    return interval.second < value;
-  };
-
-  // Find the first interval whose end >= start (might overlap)
-  auto it = std::lower_bound(intervals.begin(), intervals.end(), start, comp);
-
-  // If we found an interval and it overlaps
-  if (it != intervals.end()) {
-    // Check if the found interval overlaps
-    if (it->first < end) {
-      return true;
-    }
-  }
-
-  // Check the previous interval too (if exists) since it might extend into our new interval
-  if (it != intervals.begin()) {
-    auto prev = it - 1;
-    if (prev->second > start) {
-      return true;
-    }
-  }
-
-  return false;
-}
-
-// helper to add an interval to a sorted vector of intervals
-void QueryFull::add_sorted_interval(std::vector<std::pair<int, int>>& intervals, int start, int end)
-{
-  // Binary search to find insertion point
-  auto comp = [](int value, const std::pair<int, int>& interval) {
-    return value < interval.first;
-  };
-
-  // Find the insertion point (first interval with start >= our start)
-  auto it = std::upper_bound(intervals.begin(), intervals.end(), start, comp);
-
-  // Insert the new interval
-  intervals.insert(it, std::make_pair(start, end));
+  // The first interval whose end >= start is the only candidate, all later
+  // ones start at or after its end
+  auto it = row.lower_bound({ start, std::numeric_limits<int>::min() });
+  return it != row.end() && it->second < end;
 }
 
 const std::vector<FullOutputAlignments>& QueryFull::get_output_alignments() const
@@ -4,6 +4,7 @@
 #include "alignment_store.h"
 #include "aln_types.h"
 #include <cstdint>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -13,28 +14,77 @@ enum class HeightStyle {
   BY_MUTATIONS // sort by mutation density
 };
 
+// Output columns of full mode. alignment_index, read_id, contig_id and height
+// appear in both the alignment and the mutation table.
+enum class FullColumn {
+  ALIGNMENT_INDEX,
+  READ_ID,
+  READ_LENGTH,
+  CONTIG_ID,
+  READ_START,
+  READ_END,
+  CONTIG_START,
+  CONTIG_END,
+  IS_REVERSE,
+  CS_TAG,
+  MUTATION_COUNT,
+  HEIGHT,
+  MUTATION_TYPE,
+  MUTATION_POSITION,
+  MUTATION_DESC,
+  COUNT
+};
+
+// Columns of each output table, in output order
+extern const std::vector<FullColumn> FULL_ALIGNMENT_COLUMNS;
+extern const std::vector<FullColumn> FULL_MUTATION_COLUMNS;
+
+// Column name in the output tables
+const char* full_column_name(FullColumn column);
+
+// Set of selected output columns, all columns by default
+class FullColumns {
+  private:
+  bool selected[static_cast<int>(FullColumn::COUNT)];
+
+  public:
+  FullColumns();
+
+  // Select exactly the columns of a comma-separated list of names, or all
+  // columns for "all". Returns false and sets unknown to the first name that
+  // is not a column.
+  bool parse(const std::string& list, std::string& unknown);
+
+  bool has(FullColumn column) const { return selected[static_cast<int>(column)]; }
+
+  // Selected columns of a table, in output order
+  std::vector<FullColumn> select(const std::vector<FullColumn>& table_columns) const;
+
+  // mutation rows are only generated for a mutation-specific column
+  bool has_mutation_rows() const;
+};
+
+// String fields (read_id, contig_id, cs_tag, mutation_desc) are not stored in
+// the rows, they are resolved from the source alignment and mutation when
+// the rows are written, and only for selected columns.
 struct FullOutputAlignments {
   uint64_t alignment_index;
-  std::string read_id;
+  const Alignment* alignment;
   int read_length;
-  std::string contig_id;
   int read_start;
   int read_end;
   int contig_start;
   int contig_end;
   bool is_reverse;
-  std::string cs_tag;
   int num_mutations;
   int height;
 };
 
 struct FullOutputMutations {
   uint64_t alignment_index;
-  std::string read_id;
-  std::string contig_id;
+  const Mutation* mutation;
   MutationType type;
   int position;
-  std::string desc;
   int height;
 };
 
@@ -43,6 +93,7 @@ class QueryFull {
   std::vector<Interval> intervals;
   const AlignmentStore& store;
   HeightStyle height_style;
+  FullColumns columns;
 
   std::vector<FullOutputAlignments> output_alignments;
   std::vector<FullOutputMutations> output_mutations;
@@ -56,21 +107,31 @@ class QueryFull {
   void calculate_heights_by_coord();
   void calculate_heights_by_mutations();
 
-  // helper methods for binary search in mutation-based height calculation
-  bool has_overlap(const std::vector<std::pair<int, int>>& intervals, int start, int end);
-  void add_sorted_interval(std::vector<std::pair<int, int>>& intervals, int start, int end);
+  // intervals occupying one row in mutation-based height calculation, as (end, start)
+  using RowIntervals = std::set<std::pair<int, int>>;
+  bool has_overlap(const RowIntervals& row, int start, int end);
 
   public:
   QueryFull(const std::vector<Interval>& intervals,
       const AlignmentStore& store,
-      HeightStyle height_style = HeightStyle::BY_COORD);
+      HeightStyle height_style = HeightStyle::BY_COORD,
+      const FullColumns& columns = FullColumns());
 
   // execute the query
   void execute();
 
-  // write the output rows to a table
+  // write the output rows to a table, the alignment table is skipped if none
+  // of its columns are selected and the mutation table if no mutation rows
   void write_to_csv(const std::string& ofn_prefix);
 
+  // value of a string column of a row (read_id, contig_id, cs_tag, mutation_desc)
+  const std::string& get_read_id(const FullOutputAlignments& aln) const;
+  const std::string& get_contig_id(const FullOutputAlignments& aln) const;
+  std::string get_cs_tag(const FullOutputAlignments& aln) const;
+  std::string get_mutation_desc(const FullOutputMutations& mut) const;
+
+  const FullColumns& get_columns() const { return columns; }
+
   // getters
   const std::vector<FullOutputAlignments>& get_output_alignments() const;
   const std::vector<FullOutputMutations>& get_output_mutations() const;
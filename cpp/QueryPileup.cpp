@@ -1,11 +1,13 @@
 #include "QueryPileup.h"
-#include <algorithm> // For std::sort, std::max
+#include "IntervalBatch.h"
+#include "thread_pool.h"
+#include <algorithm> // For std::sort
 #include <cassert> // For assertions
 #include <fstream>
+#include <iterator>
 #include <iostream>
-#include <map>
-#include <numeric> // For std::accumulate
 #include <string>
+#include <utility>
 #include <vector>
 
 using namespace std;
@@ -13,103 +15,117 @@ using namespace std;
 QueryPileup::QueryPileup(
     const std::vector<Interval>& intervals,
     const AlignmentStore& store,
-    PileupReportMode report_mode)
+    PileupReportMode report_mode,
+    uint32_t window_size,
+    int num_threads,
+    const PileupFilter& filter)
     : intervals(intervals)
     , store(store)
     , report_mode(report_mode)
+    , window_size(window_size)
+    , num_threads(num_threads)
+    , filter(filter)
 {
   // Constructor implementation (basic initialization done via initializer list)
 }
 
-// Private helper function to aggregate data into pileup_results
-void QueryPileup::aggregate_data()
+// Private helper function to compute the pileup of [start, end) on a contig.
+// Coverage comes from the coverage track and variant counts from the allele
+// counts of the mutation table, so no alignment is visited. Only the runs
+// that will be reported are kept: the covered mode drops zero coverage runs
+// and the filtered kernels drop runs below -min_coverage.
+template <PileupReportMode Mode, bool Filtered>
+void QueryPileup::aggregate_window(uint32_t contig_index, uint32_t start, uint32_t end, RegionPileup& pileup) const
 {
-  pileup_results.clear(); // Ensure map is empty before starting
+  uint32_t length = end - start;
+  pileup.contig_index = contig_index;
+  pileup.start = start;
 
-  // Pre-populate pileup_results map for all positions defined by input intervals.
-  int total_positions = 0;
-  for (const auto& interval : intervals) {
-    uint32_t contig_index = store.get_contig_index(interval.contig);
-    for (uint32_t pos = interval.start; pos < interval.end; ++pos) {
-      pileup_results.try_emplace({ contig_index, pos }, PileupData());
-      total_positions++;
+  pileup.runs.clear();
+  store.for_each_coverage_run(contig_index, start, end, [&](uint32_t run_start, uint32_t run_end, uint32_t depth) {
+    int coverage = int(depth);
+    if constexpr (Mode == PileupReportMode::COVERED) {
+      if (coverage == 0) {
+        return;
+      }
     }
-  }
-  cout << "total number of queried pile-up positions: " << total_positions << endl;
-
-  // Loop through intervals (again) to process alignments associated with them
-  int processed_alignments = 0;
-  for (const auto& interval : intervals) {
-    // Get alignments overlapping this interval
-    std::vector<std::reference_wrapper<const Alignment>> alignments = store.get_alignments_in_interval(interval);
-
-    // Loop through alignments
-    for (const auto& alignment_ref : alignments) {
-      const auto& aln = alignment_ref.get();
-      uint32_t contig_index = aln.contig_index;
-
-      // Calculate coverage for relevant positions.
-      for (uint32_t pos = aln.contig_start; pos < aln.contig_end; ++pos) {
-        auto it = pileup_results.find({ contig_index, pos });
-        if (it != pileup_results.end()) {
-          it->second.coverage++;
-        }
+    if constexpr (Filtered) {
+      if (coverage < filter.min_coverage) {
+        return;
       }
+    }
+    pileup.runs.push_back({ run_start, run_end, coverage });
+  });
 
-      // Calculate mutation counts for relevant positions.
-      for (uint32_t mutation_index : aln.mutations) { // Iterate indices
-        // Fetch the mutation object
-        const Mutation& mutation = store.get_mutation(aln.contig_index, mutation_index);
-
-        // Position is now absolute contig coordinate stored in mutation
-        uint32_t mutation_contig_pos = mutation.position;
-        auto it = pileup_results.find({ contig_index, mutation_contig_pos });
-        if (it != pileup_results.end()) {
-          string mut_str = mutation.to_string();
-          it->second.mutation_counts[mut_str]++;
-        }
-      }
-      processed_alignments++;
+  // Distinct mutations of the window, already in order of position
+  pileup.slot_offsets.assign(length + 1, 0);
+  pileup.slot_mutations.clear();
+  if (pileup.runs.empty()) {
+    return;
+  }
+  store.for_each_mutation_in_interval(contig_index, start, end, [&](uint32_t mutation_index, const Mutation& mutation) {
+    if (store.get_mutation_support(contig_index, mutation_index) == 0) {
+      return;
     }
+    pileup.slot_offsets[mutation.position - start + 1]++;
+    pileup.slot_mutations.push_back(mutation_index);
+  });
+  for (uint32_t i = 0; i < length; ++i) {
+    pileup.slot_offsets[i + 1] += pileup.slot_offsets[i];
   }
 }
 
-// Private helper function to populate output_rows from pileup_results
-void QueryPileup::generate_output_rows()
+// Private helper function to append the rows of a window pileup, every
+// position of the kept runs is reported
+template <PileupReportMode Mode, bool Filtered>
+void QueryPileup::append_window_rows(const RegionPileup& pileup, std::vector<PileupOutputRow>& rows) const
 {
-  output_rows.clear(); // Ensure vector is empty
+  if (pileup.runs.empty()) {
+    return;
+  }
+  string contig_id = store.get_contig_id(pileup.contig_index);
 
-  // Loop through pileup_results map (sorted by contig_idx, position_0based).
-  for (const auto& entry : pileup_results) {
-    const auto& key = entry.first;
-    const auto& data = entry.second;
-    uint32_t contig_index = key.first;
-    uint32_t pos_0based = key.second;
+  // Scratch space reused across positions
+  std::vector<std::pair<std::string, int>> variants;
+  std::vector<std::pair<std::string, int>> insertions;
 
-    // Apply filtering based on report_mode, coverage, and mutation counts.
-    if (report_mode == PileupReportMode::COVERED && data.coverage == 0) {
-      continue;
-    }
-    if (report_mode == PileupReportMode::MUTATED && data.mutation_counts.empty()) {
-      continue;
-    }
+  for (const auto& run : pileup.runs) {
+    int coverage = run.coverage;
+    for (uint32_t position = run.start; position < run.end; ++position) {
+      uint32_t offset = position - pileup.start;
+      uint32_t slot_begin = pileup.slot_offsets[offset];
+      uint32_t slot_end = pileup.slot_offsets[offset + 1];
 
-    // Calculate position_1based.
-    uint32_t position_1based = pos_0based + 1;
+      // Observed variants at this position, formatted once per reported variant
+      int total_mutated_count = collect_position_variants<Filtered>(pileup.contig_index,
+          pileup.slot_mutations.data() + slot_begin, slot_end - slot_begin, coverage, variants, insertions);
 
-    // Get contig_id.
-    string contig_id = store.get_contig_id(contig_index);
-
-    // Calculate ref_count.
-    int total_mutated_count = 0;
-    for (const auto& mc : data.mutation_counts) {
-      total_mutated_count += mc.second;
+      append_position_rows<Mode, Filtered>(contig_id, position + 1, coverage, total_mutated_count, variants, insertions, rows);
     }
-    int ref_count = data.coverage - total_mutated_count;
-    assert(ref_count >= 0 && "Reference count cannot be negative");
+  }
+}
 
-    // Create and sort vector of observed variants (by count desc, then name asc).
-    std::vector<std::pair<std::string, int>> variants(data.mutation_counts.begin(), data.mutation_counts.end());
+// Private helper function to check a variant count against -min_count and -min_freq
+template <bool Filtered>
+bool QueryPileup::passes_count_filter(int count, int coverage) const
+{
+  if constexpr (!Filtered) {
+    return true;
+  }
+  if (count < filter.min_count) {
+    return false;
+  }
+  if (filter.min_freq > 0 && (coverage == 0 || count < filter.min_freq * coverage)) {
+    return false;
+  }
+  return true;
+}
+
+// Private helper function to sort the variants of a position by count
+// descending, then by name for ties
+static void sort_variants(std::vector<std::pair<std::string, int>>& variants)
+{
+  if (variants.size() > 1) {
     std::sort(variants.begin(), variants.end(),
         [](const auto& a, const auto& b) {
           if (a.second != b.second) {
@@ -117,43 +133,192 @@ void QueryPileup::generate_output_rows()
           }
           return a.first < b.first; // Sort by variant string ascending for ties
         });
+  }
+}
+
+// Private helper function to append the rows of one position, given its
+// coverage, the total count of its substitutions and deletions and the
+// (variant string, count) pairs of its substitutions and deletions and of its
+// insertions that passed the count filters
+template <PileupReportMode Mode, bool Filtered>
+void QueryPileup::append_position_rows(
+    const std::string& contig_id,
+    uint32_t position_1based,
+    int coverage,
+    int total_mutated_count,
+    std::vector<std::pair<std::string, int>>& variants,
+    std::vector<std::pair<std::string, int>>& insertions,
+    std::vector<PileupOutputRow>& rows) const
+{
+  // Calculate ref_count.
+  int ref_count = coverage - total_mutated_count;
+  assert(ref_count >= 0 && "Reference count cannot be negative");
 
-    int cumulative_count_for_pos = 0;
+  sort_variants(variants);
+
+  // Filtered variants have the lowest counts, so they would all come after
+  // the reported ones and the cumsum of reported rows is unchanged
+  int cumulative_count_for_pos = 0;
+
+  // Loop through sorted variants, calculate cumsum, create output rows.
+  for (const auto& variant_pair : variants) {
+    const string& mut_str = variant_pair.first;
+    int count = variant_pair.second;
+    cumulative_count_for_pos += count;
+    rows.push_back({ contig_id, position_1based, mut_str, count, coverage, cumulative_count_for_pos });
+  }
 
-    // Loop through sorted variants, calculate cumsum, create output rows.
-    for (const auto& variant_pair : variants) {
-      const string& mut_str = variant_pair.first;
-      int count = variant_pair.second;
-      cumulative_count_for_pos += count;
-      output_rows.push_back({ contig_id, position_1based, mut_str, count, data.coverage, cumulative_count_for_pos });
+  // Create REF row if ref_count > 0 (or if coverage is 0 but mode is ALL).
+  bool report_ref = ref_count > 0;
+  if constexpr (Mode == PileupReportMode::ALL) {
+    report_ref = report_ref || coverage == 0;
+  }
+  if (report_ref && passes_count_filter<Filtered>(ref_count, coverage)) {
+    rows.push_back({ contig_id, position_1based, "REF", ref_count, coverage, total_mutated_count + ref_count });
+  }
+
+  if constexpr (!Filtered) {
+    assert(cumulative_count_for_pos + ref_count == coverage && "Cumulative count must equal coverage at end of position");
+  }
+
+  // Insertions come last, with a cumsum of their own
+  sort_variants(insertions);
+  int cumulative_insertion_count = 0;
+  for (const auto& insertion_pair : insertions) {
+    cumulative_insertion_count += insertion_pair.second;
+    rows.push_back({ contig_id, position_1based, insertion_pair.first, insertion_pair.second, coverage, cumulative_insertion_count });
+  }
+}
+
+// Private helper function to append the mutated rows of [start, end) on a contig
+// from the allele counts stored with the mutation tables, without visiting alignments
+template <bool Filtered>
+void QueryPileup::append_mutated_rows(uint32_t contig_index, uint32_t start, uint32_t end, std::vector<PileupOutputRow>& rows) const
+{
+  string contig_id = store.get_contig_id(contig_index);
+  std::vector<std::pair<std::string, int>> variants;
+  std::vector<std::pair<std::string, int>> insertions;
+  std::vector<uint32_t> position_mutations;
+
+  // Mutations are visited in order of position, rows are emitted per position
+  uint32_t position = 0;
+  int coverage = 0;
+  auto flush_position = [&]() {
+    if (position_mutations.empty()) {
+      return;
     }
+    int total_mutated_count = collect_position_variants<Filtered>(contig_index,
+        position_mutations.data(), position_mutations.size(), coverage, variants, insertions);
+    append_position_rows<PileupReportMode::MUTATED, Filtered>(contig_id, position + 1, coverage, total_mutated_count, variants, insertions, rows);
+    position_mutations.clear();
+  };
 
-    // Create REF row if ref_count > 0 (or if coverage is 0 but mode is ALL).
-    if (ref_count > 0 || (data.coverage == 0 && report_mode == PileupReportMode::ALL)) {
-      cumulative_count_for_pos += ref_count;
-      output_rows.push_back({ contig_id, position_1based, "REF", ref_count, data.coverage, cumulative_count_for_pos });
+  store.for_each_mutation_in_interval(contig_index, start, end, [&](uint32_t mutation_index, const Mutation& mutation) {
+    if (!position_mutations.empty() && mutation.position != position) {
+      flush_position();
+    }
+    if (store.get_mutation_support(contig_index, mutation_index) == 0) {
+      return;
+    }
+    int mutation_coverage = store.get_mutation_coverage(contig_index, mutation_index);
+    if constexpr (Filtered) {
+      // Positions below the minimum coverage are never expanded into rows
+      if (mutation_coverage < filter.min_coverage) {
+        return;
+      }
+    }
+    if (position_mutations.empty()) {
+      position = mutation.position;
+      coverage = mutation_coverage;
     }
+    position_mutations.push_back(mutation_index);
+  });
+  flush_position();
+}
 
-    assert(cumulative_count_for_pos == data.coverage && "Cumulative count must equal coverage at end of position");
+// Private helper function to collect the variants of one position that pass
+// the count filters, returning the total count of its substitutions and
+// deletions. These replace the reference base, so with REF they count each
+// alignment once and sum to the coverage. Insertions precede the base and an
+// alignment may carry one along with a substitution or deletion, so they are
+// collected apart with their full support.
+template <bool Filtered>
+int QueryPileup::collect_position_variants(uint32_t contig_index, const uint32_t* mutation_indices, size_t num_mutations,
+    int coverage, std::vector<std::pair<std::string, int>>& variants, std::vector<std::pair<std::string, int>>& insertions) const
+{
+  const auto& mutations = store.get_contig_mutations(contig_index);
+  variants.clear();
+  insertions.clear();
+  int total_mutated_count = 0;
+  for (size_t k = 0; k < num_mutations; ++k) {
+    const Mutation& mutation = mutations[mutation_indices[k]];
+    int count = store.get_mutation_support(contig_index, mutation_indices[k]);
+    bool is_insertion = mutation.type == MutationType::INSERTION;
+    if (!is_insertion) {
+      total_mutated_count += count;
+    }
+    if (count > 0 && passes_count_filter<Filtered>(count, coverage)) {
+      (is_insertion ? insertions : variants).emplace_back(mutation.to_string(), count);
+    }
   }
+  return total_mutated_count;
 }
 
-// Private helper function to write output_rows to file
-void QueryPileup::write_rows_to_file(const std::string& ofn_prefix)
+// Private helper function to append the rows of [start, end) on a contig with
+// one specialized kernel. The all and covered modes walk the coverage runs of
+// the window; the mutated mode takes a sparse path that only looks at the
+// distinct mutations of the window, so its cost does not depend on the window
+// length or on the depth.
+template <PileupReportMode Mode, bool Filtered>
+void QueryPileup::pileup_window_kernel(uint32_t contig_index, uint32_t start, uint32_t end, std::vector<PileupOutputRow>& rows) const
 {
-  string filename = ofn_prefix + "_pileup.tsv";
-  cout << "writing pileup data to " << filename << endl;
-  ofstream ofs(filename);
+  if constexpr (Mode == PileupReportMode::MUTATED) {
+    append_mutated_rows<Filtered>(contig_index, start, end, rows);
+  } else {
+    RegionPileup pileup;
+    aggregate_window<Mode, Filtered>(contig_index, start, end, pileup);
+    append_window_rows<Mode, Filtered>(pileup, rows);
+  }
+}
 
-  if (!ofs.is_open()) {
-    cerr << "error: could not open file " << filename << endl;
-    exit(1); // Abort as per instructions
+// Private helper function to append the rows of [start, end) on a contig,
+// dispatching once to the kernel of the report mode and filters
+void QueryPileup::pileup_window(uint32_t contig_index, uint32_t start, uint32_t end, std::vector<PileupOutputRow>& rows) const
+{
+  bool filtered = filter.min_coverage > 0 || filter.min_count > 0 || filter.min_freq > 0;
+  switch (report_mode) {
+  case PileupReportMode::ALL:
+    if (filtered) {
+      pileup_window_kernel<PileupReportMode::ALL, true>(contig_index, start, end, rows);
+    } else {
+      pileup_window_kernel<PileupReportMode::ALL, false>(contig_index, start, end, rows);
+    }
+    break;
+  case PileupReportMode::COVERED:
+    if (filtered) {
+      pileup_window_kernel<PileupReportMode::COVERED, true>(contig_index, start, end, rows);
+    } else {
+      pileup_window_kernel<PileupReportMode::COVERED, false>(contig_index, start, end, rows);
+    }
+    break;
+  case PileupReportMode::MUTATED:
+    if (filtered) {
+      pileup_window_kernel<PileupReportMode::MUTATED, true>(contig_index, start, end, rows);
+    } else {
+      pileup_window_kernel<PileupReportMode::MUTATED, false>(contig_index, start, end, rows);
+    }
+    break;
   }
+}
 
-  // Write header
+void QueryPileup::write_header(std::ofstream& ofs) const
+{
   ofs << "contig\tposition\tvariant\tcount\tcoverage\tcumsum\n";
+}
 
-  for (const auto& row : output_rows) {
+void QueryPileup::write_rows(std::ofstream& ofs, const std::vector<PileupOutputRow>& rows) const
+{
+  for (const auto& row : rows) {
     ofs << row.contig << "\t"
         << row.position << "\t"
         << row.variant << "\t"
@@ -161,6 +326,22 @@ void QueryPileup::write_rows_to_file(const std::string& ofn_prefix)
         << row.coverage << "\t"
         << row.cumsum << "\n";
   }
+}
+
+// Private helper function to write output_rows to file
+void QueryPileup::write_rows_to_file(const std::string& ofn_prefix)
+{
+  string filename = ofn_prefix + "_pileup.tsv";
+  cout << "writing pileup data to " << filename << endl;
+  ofstream ofs(filename);
+
+  if (!ofs.is_open()) {
+    cerr << "error: could not open file " << filename << endl;
+    exit(1); // Abort as per instructions
+  }
+
+  write_header(ofs);
+  write_rows(ofs, output_rows);
 
   ofs.close();
   cout << "wrote " << output_rows.size() << " rows to " << filename << endl;
@@ -172,10 +353,83 @@ void QueryPileup::write_to_csv(const std::string& ofn_prefix)
   write_rows_to_file(ofn_prefix);
 }
 
+std::vector<PileupWindow> QueryPileup::split_windows(const IntervalBatch& batch) const
+{
+  massert(window_size > 0, "pileup window size must be positive");
+  std::vector<PileupWindow> windows;
+  for (const auto& region : batch.get_regions()) {
+    for (uint32_t start = region.start; start < region.end;) {
+      uint32_t end = region.end - start > window_size ? start + window_size : region.end;
+      windows.push_back({ region.contig_index, start, end });
+      start = end;
+    }
+  }
+  return windows;
+}
+
+// Private helper function that computes the rows of each window and passes
+// them to consume, in window order. Windows are independent, since each one
+// looks up its own alignments and clips them, so they are computed in batches
+// of a few windows per thread and handed over in order once a batch is done.
+void QueryPileup::run_windows(const std::function<void(std::vector<PileupOutputRow>&)>& consume) const
+{
+  // Overlapping intervals are merged, so each alignment is counted once per position
+  IntervalBatch batch(intervals, store);
+
+  uint64_t total_positions = 0;
+  for (const auto& region : batch.get_regions()) {
+    total_positions += region.end - region.start;
+  }
+  cout << "total number of queried pile-up positions: " << total_positions << endl;
+
+  std::vector<PileupWindow> windows = split_windows(batch);
+  size_t batch_size = 4 * size_t(std::max(num_threads, 1));
+  std::vector<std::vector<PileupOutputRow>> window_rows;
+  for (size_t first = 0; first < windows.size(); first += batch_size) {
+    size_t n = std::min(batch_size, windows.size() - first);
+    window_rows.assign(n, std::vector<PileupOutputRow>());
+    parallel_for(n, num_threads, [&](size_t i) {
+      const PileupWindow& window = windows[first + i];
+      pileup_window(window.contig_index, window.start, window.end, window_rows[i]);
+    });
+    for (auto& rows : window_rows) {
+      consume(rows);
+    }
+  }
+}
+
 void QueryPileup::execute()
 {
-  aggregate_data();
-  generate_output_rows();
+  output_rows.clear(); // Ensure vector is empty
+
+  run_windows([&](std::vector<PileupOutputRow>& rows) {
+    output_rows.insert(output_rows.end(), std::make_move_iterator(rows.begin()), std::make_move_iterator(rows.end()));
+  });
+}
+
+void QueryPileup::stream_to_csv(const std::string& ofn_prefix)
+{
+  string filename = ofn_prefix + "_pileup.tsv";
+  cout << "streaming pileup data to " << filename << " in windows of " << window_size << " bp" << endl;
+  ofstream ofs(filename);
+
+  if (!ofs.is_open()) {
+    cerr << "error: could not open file " << filename << endl;
+    exit(1);
+  }
+
+  write_header(ofs);
+
+  // Rows of each window are written and released as soon as they are final
+  size_t total_rows = 0;
+  run_windows([&](std::vector<PileupOutputRow>& rows) {
+    write_rows(ofs, rows);
+    total_rows += rows.size();
+    std::vector<PileupOutputRow>().swap(rows);
+  });
+
+  ofs.close();
+  cout << "wrote " << total_rows << " rows to " << filename << endl;
 }
 
 // function that converts a string to a PileupReportMode enum
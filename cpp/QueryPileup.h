@@ -1,26 +1,58 @@
 #ifndef QUERYPILEUP_H
 #define QUERYPILEUP_H
 
+#include "IntervalBatch.h"
 #include "alignment_store.h" // Includes aln_types.h indirectly
-#include <map>
+#include <cstdint>
+#include <fstream>
+#include <functional>
 #include <string>
-#include <utility> // For std::pair
+#include <utility>
 #include <vector>
 
 // Enum to control output verbosity for pileup
 enum class PileupReportMode {
   ALL, // Report every position within the query intervals
   COVERED, // Report only positions with coverage > 0
-  MUTATED // Report only positions with at least one mutation observed
+  MUTATED // Report only positions with at least one mutation observed, answered
+  // sparsely from the mutation table and its stored allele counts
 };
 
 PileupReportMode string_to_pileup_report_mode(const string& mode);
 
-// Data structure to hold aggregated results for a single genomic position
-struct PileupData {
-  int coverage = 0;
-  // Stores counts for specific mutations observed at this position
-  std::map<std::string, int> mutation_counts; // Key: Mutation::to_string(), Value: count
+// Row filters applied while the pileup is generated, rows that fail are never
+// formatted. Counts and frequencies apply to variant and REF rows alike.
+struct PileupFilter {
+  int min_coverage = 0; // skip positions with lower coverage
+  int min_count = 0; // skip rows with a lower count
+  double min_freq = 0; // skip rows with a lower count / coverage
+};
+
+// A run of positions [start, end) of equal coverage
+struct PileupCoverageRun {
+  uint32_t start;
+  uint32_t end; // exclusive
+  int coverage;
+};
+
+// Pileup of one window of a merged query region, indexed by offset from the window start
+struct RegionPileup {
+  uint32_t contig_index;
+  uint32_t start;
+  // Coverage runs of the window that are reported, taken from the coverage
+  // track; runs the report mode or the filters exclude are dropped
+  std::vector<PileupCoverageRun> runs;
+  // Flat variant slot table: the distinct mutation indices observed at offset i
+  // are slot_mutations[slot_offsets[i] .. slot_offsets[i + 1])
+  std::vector<uint32_t> slot_offsets;
+  std::vector<uint32_t> slot_mutations;
+};
+
+// A window of a merged query region, the unit of work of the pileup
+struct PileupWindow {
+  uint32_t contig_index;
+  uint32_t start;
+  uint32_t end; // exclusive
 };
 
 // Data structure representing a single row in the pileup output file
@@ -38,18 +70,43 @@ class QueryPileup {
   const std::vector<Interval>& intervals;
   const AlignmentStore& store;
   PileupReportMode report_mode;
+  uint32_t window_size;
+  int num_threads;
+  PileupFilter filter;
 
-  // Use a map to store results, keyed by {contig_index, position (0-based)}
-  std::map<std::pair<uint32_t, uint32_t>, PileupData> pileup_results;
   // Vector to store the formatted output rows before writing
   std::vector<PileupOutputRow> output_rows;
 
-  void aggregate_data();
-  void generate_output_rows();
+  // Pileup kernels, specialized on the report mode and on whether any filter
+  // is set, so that each combination only carries the checks it needs
+  template <PileupReportMode Mode, bool Filtered>
+  void aggregate_window(uint32_t contig_index, uint32_t start, uint32_t end, RegionPileup& pileup) const;
+  template <PileupReportMode Mode, bool Filtered>
+  void append_window_rows(const RegionPileup& pileup, std::vector<PileupOutputRow>& rows) const;
+  template <bool Filtered>
+  void append_mutated_rows(uint32_t contig_index, uint32_t start, uint32_t end, std::vector<PileupOutputRow>& rows) const;
+  template <PileupReportMode Mode, bool Filtered>
+  void append_position_rows(const std::string& contig_id, uint32_t position_1based, int coverage, int total_mutated_count,
+      std::vector<std::pair<std::string, int>>& variants, std::vector<std::pair<std::string, int>>& insertions,
+      std::vector<PileupOutputRow>& rows) const;
+  template <bool Filtered>
+  int collect_position_variants(uint32_t contig_index, const uint32_t* mutation_indices, size_t num_mutations, int coverage,
+      std::vector<std::pair<std::string, int>>& variants, std::vector<std::pair<std::string, int>>& insertions) const;
+  template <bool Filtered>
+  bool passes_count_filter(int count, int coverage) const;
+  template <PileupReportMode Mode, bool Filtered>
+  void pileup_window_kernel(uint32_t contig_index, uint32_t start, uint32_t end, std::vector<PileupOutputRow>& rows) const;
+  void pileup_window(uint32_t contig_index, uint32_t start, uint32_t end, std::vector<PileupOutputRow>& rows) const;
+  void write_header(std::ofstream& ofs) const;
+  void write_rows(std::ofstream& ofs, const std::vector<PileupOutputRow>& rows) const;
   void write_rows_to_file(const std::string& ofn_prefix);
+  std::vector<PileupWindow> split_windows(const IntervalBatch& batch) const;
+  void run_windows(const std::function<void(std::vector<PileupOutputRow>&)>& consume) const;
 
   public:
-  QueryPileup(const std::vector<Interval>& intervals, const AlignmentStore& store, PileupReportMode report_mode);
+  // Intervals are processed in windows of window_size bp, num_threads windows at a time
+  QueryPileup(const std::vector<Interval>& intervals, const AlignmentStore& store, PileupReportMode report_mode,
+      uint32_t window_size = 1000000, int num_threads = 1, const PileupFilter& filter = PileupFilter());
 
   // execute the query
   void execute();
@@ -57,6 +114,10 @@ class QueryPileup {
   // write the output rows to a table
   void write_to_csv(const std::string& ofn_prefix);
 
+  // execute the query and write the table window by window, without keeping
+  // the output rows; memory is bounded by the window size, depth and threads
+  void stream_to_csv(const std::string& ofn_prefix);
+
   // get access to output rows
   const std::vector<PileupOutputRow>& get_output_rows() const
   {
@@ -0,0 +1,83 @@
+#include "QueryRead.h"
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+using namespace std;
+
+QueryRead::QueryRead(const std::vector<std::string>& read_ids, const AlignmentStore& store)
+    : read_ids(read_ids)
+    , store(store)
+{
+}
+
+void QueryRead::execute()
+{
+  output_rows.clear();
+  missing_read_ids.clear();
+
+  // Reads are reported in input order, each read once
+  std::unordered_set<size_t> seen_read_indices;
+  for (const auto& read_id : read_ids) {
+    size_t read_index;
+    try {
+      read_index = store.get_read_index(read_id);
+    } catch (const std::runtime_error&) {
+      // Read ID not found, just skip it
+      missing_read_ids.push_back(read_id);
+      cerr << "warning: read ID '" << read_id << "' not found, skipping" << endl;
+      continue;
+    }
+    if (!seen_read_indices.insert(read_index).second) {
+      continue;
+    }
+
+    const Read& read = store.get_reads()[read_index];
+    store.for_each_alignment_of_read(read_index, [&](size_t alignment_index) {
+      const Alignment& aln = store.get_alignments()[alignment_index];
+      output_rows.push_back({ alignment_index,
+          read.id,
+          static_cast<int>(read.length),
+          store.get_contig_id(aln.contig_index),
+          static_cast<int>(aln.read_start),
+          static_cast<int>(aln.read_end),
+          static_cast<int>(aln.contig_start),
+          static_cast<int>(aln.contig_end),
+          aln.is_reverse,
+          static_cast<int>(aln.mutations.size()) });
+    });
+  }
+}
+
+void QueryRead::write_to_csv(const std::string& ofn_prefix)
+{
+  string filename = ofn_prefix + "_read_alignments.tsv";
+  cout << "writing read alignments to " << filename << endl;
+  ofstream ofs(filename);
+
+  if (!ofs.is_open()) {
+    cerr << "error: could not open file " << filename << endl;
+    exit(1);
+  }
+
+  ofs << "alignment_index\tread_id\tread_length\tcontig_id\tread_start\tread_end\tcontig_start\tcontig_end\tis_reverse\tmutation_count\n";
+
+  for (const auto& row : output_rows) {
+    ofs << row.alignment_index << "\t"
+        << row.read_id << "\t"
+        << row.read_length << "\t"
+        << row.contig_id << "\t"
+        << row.read_start << "\t"
+        << row.read_end << "\t"
+        << row.contig_start << "\t"
+        << row.contig_end << "\t"
+        << (row.is_reverse ? "true" : "false") << "\t"
+        << row.num_mutations << "\n";
+  }
+
+  ofs.close();
+  cout << "wrote " << output_rows.size() << " alignments to " << filename << endl;
+}
@@ -0,0 +1,47 @@
+#ifndef QUERYREAD_H
+#define QUERYREAD_H
+
+#include "alignment_store.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Data structure representing a single alignment of a queried read
+struct ReadOutputRow {
+  uint64_t alignment_index;
+  std::string read_id;
+  int read_length;
+  std::string contig_id;
+  int read_start;
+  int read_end;
+  int contig_start;
+  int contig_end;
+  bool is_reverse;
+  int num_mutations;
+};
+
+class QueryRead {
+  private:
+  const std::vector<std::string>& read_ids;
+  const AlignmentStore& store;
+
+  std::vector<ReadOutputRow> output_rows;
+  std::vector<std::string> missing_read_ids;
+
+  public:
+  QueryRead(const std::vector<std::string>& read_ids, const AlignmentStore& store);
+
+  // execute the query, using the read index of the store
+  void execute();
+
+  // write the output rows to a table
+  void write_to_csv(const std::string& ofn_prefix);
+
+  // Getter for R interface
+  const std::vector<ReadOutputRow>& get_output_rows() const { return output_rows; }
+
+  // Read IDs of the query that are not in the store
+  const std::vector<std::string>& get_missing_read_ids() const { return missing_read_ids; }
+};
+
+#endif // QUERYREAD_H
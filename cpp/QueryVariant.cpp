@@ -0,0 +1,92 @@
+#include "QueryVariant.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+QueryVariant::QueryVariant(const std::vector<Variant>& variants, const AlignmentStore& store)
+    : variants(variants)
+    , store(store)
+{
+}
+
+bool QueryVariant::find_mutation_index(uint32_t contig_index, const Variant& variant, uint32_t& mutation_index) const
+{
+  // only the mutations at the variant position are compared
+  bool found = false;
+  store.for_each_mutation_in_interval(contig_index, variant.position, variant.position + 1, [&](uint32_t index, const Mutation& mutation) {
+    if (!found && mutation.to_string() == variant.desc) {
+      mutation_index = index;
+      found = true;
+    }
+  });
+  return found;
+}
+
+void QueryVariant::execute()
+{
+  output_rows.clear();
+  missing_variants.clear();
+
+  vector<uint32_t> supporting;
+  for (const auto& variant : variants) {
+    uint32_t contig_index = store.get_contig_index(variant.contig);
+
+    // Alignments carrying the variant, sorted by alignment index
+    supporting.clear();
+    uint32_t mutation_index;
+    if (find_mutation_index(contig_index, variant, mutation_index)) {
+      store.for_each_alignment_with_mutation(contig_index, mutation_index, [&](size_t alignment_index) {
+        supporting.push_back(alignment_index);
+      });
+    } else {
+      missing_variants.push_back(variant);
+      cerr << "warning: variant " << variant.contig << ":" << variant.position + 1 << " " << variant.desc
+           << " not found, reporting all covering alignments as non-supporting" << endl;
+    }
+
+    // Report all alignments covering the position, flagging the supporting ones
+    store.for_each_alignment_in_interval(contig_index, variant.position, variant.position, [&](const Alignment& aln) {
+      size_t alignment_index = store.get_alignment_index(aln);
+      bool is_supporting = std::binary_search(supporting.begin(), supporting.end(), alignment_index);
+      if (!is_supporting && variant.position >= aln.contig_end) {
+        return;
+      }
+      output_rows.push_back({ variant.contig,
+          variant.position + 1,
+          variant.desc,
+          alignment_index,
+          store.get_read_id(aln.read_index),
+          is_supporting });
+    });
+  }
+}
+
+void QueryVariant::write_to_csv(const std::string& ofn_prefix)
+{
+  string filename = ofn_prefix + "_variant_reads.tsv";
+  cout << "writing variant reads to " << filename << endl;
+  ofstream ofs(filename);
+
+  if (!ofs.is_open()) {
+    cerr << "error: could not open file " << filename << endl;
+    exit(1);
+  }
+
+  ofs << "contig\tposition\tvariant\talignment_index\tread_id\tsupporting\n";
+
+  for (const auto& row : output_rows) {
+    ofs << row.contig << "\t"
+        << row.position << "\t"
+        << row.variant << "\t"
+        << row.alignment_index << "\t"
+        << row.read_id << "\t"
+        << (row.supporting ? "true" : "false") << "\n";
+  }
+
+  ofs.close();
+  cout << "wrote " << output_rows.size() << " rows to " << filename << endl;
+}
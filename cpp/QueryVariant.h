@@ -0,0 +1,46 @@
+#ifndef QUERYVARIANT_H
+#define QUERYVARIANT_H
+
+#include "alignment_store.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Data structure representing one alignment covering a queried variant
+struct VariantOutputRow {
+  std::string contig;
+  uint32_t position; // 1-based
+  std::string variant;
+  uint64_t alignment_index;
+  std::string read_id;
+  bool supporting; // true if the alignment carries the variant
+};
+
+class QueryVariant {
+  private:
+  const std::vector<Variant>& variants;
+  const AlignmentStore& store;
+
+  std::vector<VariantOutputRow> output_rows;
+  std::vector<Variant> missing_variants;
+
+  // returns false if the variant is not in the mutation table of the contig
+  bool find_mutation_index(uint32_t contig_index, const Variant& variant, uint32_t& mutation_index) const;
+
+  public:
+  QueryVariant(const std::vector<Variant>& variants, const AlignmentStore& store);
+
+  // execute the query, using the mutation index of the store
+  void execute();
+
+  // write the output rows to a table
+  void write_to_csv(const std::string& ofn_prefix);
+
+  // Getter for R interface
+  const std::vector<VariantOutputRow>& get_output_rows() const { return output_rows; }
+
+  // Variants of the query that are not in the store
+  const std::vector<Variant>& get_missing_variants() const { return missing_variants; }
+};
+
+#endif // QUERYVARIANT_H
@@ -0,0 +1,68 @@
+#include "QueryVariantTable.h"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+QueryVariantTable::QueryVariantTable(const std::vector<Interval>& intervals, const AlignmentStore& store)
+    : intervals(intervals)
+    , store(store)
+{
+}
+
+void QueryVariantTable::execute()
+{
+  output_rows.clear();
+
+  for (const auto& interval : intervals) {
+    uint32_t contig_index = store.get_contig_index(interval.contig);
+    store.for_each_mutation_in_interval(contig_index, interval.start, interval.end, [&](uint32_t mutation_index, const Mutation& mutation) {
+      ostringstream type;
+      type << mutation.type;
+      // Allele counts are precomputed in the ALN file
+      uint32_t support = store.get_mutation_support(contig_index, mutation_index);
+      uint32_t coverage = store.get_mutation_coverage(contig_index, mutation_index);
+      output_rows.push_back({ interval.contig,
+          interval.start,
+          interval.end,
+          mutation.position + 1,
+          type.str(),
+          mutation.to_string(),
+          support,
+          coverage,
+          coverage > 0 ? double(support) / coverage : 0.0 });
+    });
+  }
+}
+
+void QueryVariantTable::write_to_csv(const std::string& ofn_prefix)
+{
+  string filename = ofn_prefix + "_variants.tsv";
+  cout << "writing variants to " << filename << endl;
+  ofstream ofs(filename);
+
+  if (!ofs.is_open()) {
+    cerr << "error: could not open file " << filename << endl;
+    exit(1);
+  }
+
+  ofs << "contig\tinterval_start\tinterval_end\tposition\ttype\tvariant\tsupport\tcoverage\tfrequency\n";
+
+  for (const auto& row : output_rows) {
+    ofs << row.contig << "\t"
+        << row.interval_start << "\t"
+        << row.interval_end << "\t"
+        << row.position << "\t"
+        << row.type << "\t"
+        << row.variant << "\t"
+        << row.support << "\t"
+        << row.coverage << "\t"
+        << row.frequency << "\n";
+  }
+
+  ofs.close();
+  cout << "wrote " << output_rows.size() << " rows to " << filename << endl;
+}
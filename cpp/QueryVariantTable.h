@@ -0,0 +1,42 @@
+#ifndef QUERYVARIANTTABLE_H
+#define QUERYVARIANTTABLE_H
+
+#include "alignment_store.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Data structure representing one distinct mutation within a query interval
+struct VariantTableOutputRow {
+  std::string contig;
+  uint32_t interval_start;
+  uint32_t interval_end;
+  uint32_t position; // 1-based
+  std::string type;
+  std::string variant;
+  uint32_t support; // alignments carrying the mutation
+  uint32_t coverage; // alignments covering the position
+  double frequency; // support / coverage, 0 if not covered
+};
+
+class QueryVariantTable {
+  private:
+  const std::vector<Interval>& intervals;
+  const AlignmentStore& store;
+
+  std::vector<VariantTableOutputRow> output_rows;
+
+  public:
+  QueryVariantTable(const std::vector<Interval>& intervals, const AlignmentStore& store);
+
+  // execute the query, using the mutation position index of the store
+  void execute();
+
+  // write the output rows to a table
+  void write_to_csv(const std::string& ofn_prefix);
+
+  // Getter for R interface
+  const std::vector<VariantTableOutputRow>& get_output_rows() const { return output_rows; }
+};
+
+#endif // QUERYVARIANTTABLE_H
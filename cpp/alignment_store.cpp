@@ -26,13 +26,22 @@ static void write_string(std::ofstream& file, const string& str)
   file.write(str.c_str(), len);
 }
 
+// Helper function to read a value from binary file
+template <typename T>
+static void read_value(std::ifstream& file, T& value)
+{
+  file.read(reinterpret_cast<char*>(&value), sizeof(T));
+  massert(file.good(), "unexpected end of file");
+}
+
 // Helper function to read string from binary file
 static string read_string(std::ifstream& file)
 {
   size_t len;
-  file.read(reinterpret_cast<char*>(&len), sizeof(len));
+  read_value(file, len);
   string str(len, '\0');
   file.read(&str[0], len);
+  massert(file.good(), "unexpected end of file");
   return str;
 }
 
@@ -45,6 +54,13 @@ const Mutation& AlignmentStore::get_mutation(uint32_t contig_idx, uint32_t mutat
   return contig_it->second[mutation_idx];
 }
 
+const std::vector<Mutation>& AlignmentStore::get_contig_mutations(uint32_t contig_idx) const
+{
+  static const std::vector<Mutation> no_mutations;
+  auto contig_it = mutations_.find(contig_idx);
+  return contig_it != mutations_.end() ? contig_it->second : no_mutations;
+}
+
 void AlignmentStore::save(const string& filename)
 {
   ofstream file(filename, ios::binary);
@@ -114,13 +130,14 @@ void AlignmentStore::save(const string& filename)
     }
   }
 
-  file.close();
-
   // Set loaded flag to prevent further mutation additions via add_mutation
   loaded_ = true;
 
-  // Organize alignments after loading
+  // Organize alignments before saving, so that indices are written along with the data
   organize_alignments();
+  save_sections(file);
+
+  file.close();
 }
 
 void AlignmentStore::load(const string& filename)
@@ -144,42 +161,49 @@ void AlignmentStore::load(const string& filename)
   read_id_to_index.clear();
   contig_id_to_index.clear();
   alignment_index_by_contig_.clear();
-  max_alignment_length_ = 0;
+  alignment_index_by_read_.clear();
+  read_alignment_offsets_.clear();
+  alignment_index_by_mutation_.clear();
+  mutation_index_by_position_.clear();
+  allele_counts_by_contig_.clear();
+  coverage_tracks_.clear();
+  zoom_pyramids_.clear();
 
   // Load contigs
   size_t num_contigs;
-  file.read(reinterpret_cast<char*>(&num_contigs), sizeof(num_contigs));
+  read_value(file, num_contigs);
   contigs_.reserve(num_contigs);
   for (size_t i = 0; i < num_contigs; ++i) {
     string id = read_string(file);
     uint32_t length;
-    file.read(reinterpret_cast<char*>(&length), sizeof(length));
+    read_value(file, length);
     contigs_.emplace_back(id, length);
     contig_id_to_index[id] = i;
   }
 
   // Load reads
   size_t num_reads;
-  file.read(reinterpret_cast<char*>(&num_reads), sizeof(num_reads));
+  read_value(file, num_reads);
   reads_.reserve(num_reads);
+  read_id_to_index.reserve(num_reads);
   for (size_t i = 0; i < num_reads; ++i) {
     string id = read_string(file);
     uint32_t length;
-    file.read(reinterpret_cast<char*>(&length), sizeof(length));
+    read_value(file, length);
     reads_.emplace_back(id, length);
     read_id_to_index[id] = i;
   }
 
   // Load mutations_ map
   size_t num_contigs_with_mutations;
-  file.read(reinterpret_cast<char*>(&num_contigs_with_mutations), sizeof(num_contigs_with_mutations));
+  read_value(file, num_contigs_with_mutations);
 
   for (size_t i = 0; i < num_contigs_with_mutations; ++i) {
     uint32_t contig_index;
-    file.read(reinterpret_cast<char*>(&contig_index), sizeof(contig_index));
+    read_value(file, contig_index);
 
     size_t num_mutations_for_contig;
-    file.read(reinterpret_cast<char*>(&num_mutations_for_contig), sizeof(num_mutations_for_contig));
+    read_value(file, num_mutations_for_contig);
 
     // Prepare vector for this contig's mutations
     vector<Mutation> mutations_vec;
@@ -187,11 +211,11 @@ void AlignmentStore::load(const string& filename)
 
     for (size_t j = 0; j < num_mutations_for_contig; ++j) {
       MutationType type;
-      file.read(reinterpret_cast<char*>(&type), sizeof(type));
+      read_value(file, type);
 
       // Always load position as uint32_t
       uint32_t position;
-      file.read(reinterpret_cast<char*>(&position), sizeof(position));
+      read_value(file, position);
 
       // Read nts string
       string nts = read_string(file);
@@ -205,78 +229,684 @@ void AlignmentStore::load(const string& filename)
 
   // Load alignments
   size_t num_alignments;
-  file.read(reinterpret_cast<char*>(&num_alignments), sizeof(num_alignments));
+  read_value(file, num_alignments);
   alignments_.reserve(num_alignments);
   for (size_t i = 0; i < num_alignments; ++i) {
     Alignment alignment;
 
     // Read basic alignment data
-    file.read(reinterpret_cast<char*>(&alignment.read_index), sizeof(alignment.read_index));
-    file.read(reinterpret_cast<char*>(&alignment.contig_index), sizeof(alignment.contig_index));
-    file.read(reinterpret_cast<char*>(&alignment.read_start), sizeof(alignment.read_start));
-    file.read(reinterpret_cast<char*>(&alignment.read_end), sizeof(alignment.read_end));
-    file.read(reinterpret_cast<char*>(&alignment.contig_start), sizeof(alignment.contig_start));
-    file.read(reinterpret_cast<char*>(&alignment.contig_end), sizeof(alignment.contig_end));
-    file.read(reinterpret_cast<char*>(&alignment.is_reverse), sizeof(alignment.is_reverse));
-
-    // Read mutation indices
+    read_value(file, alignment.read_index);
+    read_value(file, alignment.contig_index);
+    read_value(file, alignment.read_start);
+    read_value(file, alignment.read_end);
+    read_value(file, alignment.contig_start);
+    read_value(file, alignment.contig_end);
+    read_value(file, alignment.is_reverse);
+
+    // Read mutation indices, stored contiguously
     size_t num_mutation_indices;
-    file.read(reinterpret_cast<char*>(&num_mutation_indices), sizeof(num_mutation_indices));
-    alignment.mutations.reserve(num_mutation_indices); // Reserve space in vector<uint32_t>
-    for (size_t j = 0; j < num_mutation_indices; ++j) {
-      uint32_t mutation_index;
-      file.read(reinterpret_cast<char*>(&mutation_index), sizeof(mutation_index));
-      alignment.mutations.push_back(mutation_index);
-    }
+    read_value(file, num_mutation_indices);
+    alignment.mutations.resize(num_mutation_indices);
+    file.read(reinterpret_cast<char*>(alignment.mutations.data()), num_mutation_indices * sizeof(uint32_t));
+    massert(file.good(), "unexpected end of file");
 
     alignments_.push_back(std::move(alignment)); // Use move constructor
   }
 
-  file.close();
-
   // Set loaded flag to prevent further mutation additions via add_mutation
   loaded_ = true;
 
-  // Organize alignments after loading
-  organize_alignments();
+  // Read persisted indices, rebuilding any that are missing (e.g. older files)
+  load_sections(file);
+  if (alignment_index_by_contig_.size() != contigs_.size()) {
+    build_alignment_index();
+  }
+  if (read_alignment_offsets_.size() != reads_.size() + 1) {
+    build_read_index();
+  }
+  if (alignment_index_by_mutation_.size() != contigs_.size()) {
+    build_mutation_index();
+  }
+  if (mutation_index_by_position_.size() != contigs_.size()) {
+    build_mutation_position_index();
+  }
+  if (allele_counts_by_contig_.size() != contigs_.size()) {
+    build_allele_counts();
+  }
+  if (coverage_tracks_.size() != contigs_.size()) {
+    build_coverage_tracks();
+  }
+  if (zoom_pyramids_.size() != contigs_.size()) {
+    build_zoom_pyramids();
+  }
 }
 
 void AlignmentStore::organize_alignments()
 {
-  alignment_index_by_contig_.clear();
-  max_alignment_length_ = 0; // Initialize max length calculation
+  build_alignment_index();
+  build_read_index();
+  build_mutation_index();
+  build_mutation_position_index();
+  build_allele_counts();
+  build_coverage_tracks();
+  build_zoom_pyramids();
+}
 
-  // Pre-allocate buckets for each contig
-  for (size_t i = 0; i < contigs_.size(); ++i) {
-    alignment_index_by_contig_[i] = {};
-  }
+void AlignmentStore::build_alignment_index()
+{
+  massert(alignments_.size() < std::numeric_limits<uint32_t>::max(), "too many alignments for index: %zu", alignments_.size());
+  alignment_index_by_contig_.assign(contigs_.size(), ContigAlignmentIndex());
 
   for (size_t i = 0; i < alignments_.size(); ++i) {
     const auto& alignment = alignments_[i];
+    massert(alignment.contig_index < contigs_.size(), "alignment references unknown contig index %u", alignment.contig_index);
+    massert(alignment.contig_end >= alignment.contig_start, "alignment with end < start found (index %zu)", i);
+    alignment_index_by_contig_[alignment.contig_index].order.push_back(i);
+  }
 
-    // Add index to the map
-    auto it = alignment_index_by_contig_.find(alignment.contig_index);
-    massert(it != alignment_index_by_contig_.end(), "alignment references unknown contig index %zu", alignment.contig_index);
-    it->second.push_back(i);
+  for (auto& index : alignment_index_by_contig_) {
+    // Sort the alignment indices within each contig based on start position
+    auto& order = index.order;
+    std::sort(order.begin(), order.end(),
+        [this](uint32_t index_a, uint32_t index_b) {
+          return alignments_[index_a].contig_start < alignments_[index_b].contig_start;
+        });
 
-    // Calculate and update max alignment length
-    massert(alignment.contig_end >= alignment.contig_start, "alignment with end < start found (index %zu)", i);
-    uint32_t current_length = alignment.contig_end - alignment.contig_start; // Length is end - start
-    if (current_length > max_alignment_length_) {
-      max_alignment_length_ = current_length;
+    // Build the interval tree over the sorted alignments
+    itree_build(
+        order.size(), [&](size_t i) { return alignments_[order[i]].contig_end; }, index.max_end);
+  }
+}
+
+void AlignmentStore::build_read_index()
+{
+  // Counting sort of alignments by read, stable so each read keeps store order
+  read_alignment_offsets_.assign(reads_.size() + 1, 0);
+  for (const auto& alignment : alignments_) {
+    massert(alignment.read_index < reads_.size(), "alignment references unknown read index %u", alignment.read_index);
+    read_alignment_offsets_[alignment.read_index + 1]++;
+  }
+  for (size_t r = 0; r < reads_.size(); ++r) {
+    read_alignment_offsets_[r + 1] += read_alignment_offsets_[r];
+  }
+
+  vector<uint32_t> next(read_alignment_offsets_.begin(), read_alignment_offsets_.end() - 1);
+  alignment_index_by_read_.resize(alignments_.size());
+  for (size_t i = 0; i < alignments_.size(); ++i) {
+    alignment_index_by_read_[next[alignments_[i].read_index]++] = i;
+  }
+}
+
+void AlignmentStore::build_mutation_index()
+{
+  alignment_index_by_mutation_.assign(contigs_.size(), MutationAlignmentIndex());
+
+  // Count alignments per mutation
+  for (size_t c = 0; c < contigs_.size(); ++c) {
+    alignment_index_by_mutation_[c].offsets.assign(get_contig_mutations(c).size() + 1, 0);
+  }
+  for (const auto& alignment : alignments_) {
+    auto& offsets = alignment_index_by_mutation_[alignment.contig_index].offsets;
+    for (uint32_t mutation_index : alignment.mutations) {
+      massert(mutation_index + 1 < offsets.size(), "mutation index %u out of bounds for contig %u", mutation_index, alignment.contig_index);
+      offsets[mutation_index + 1]++;
     }
   }
 
-  // Sort the alignment indices within each contig's vector based on start position
-  for (auto& pair : alignment_index_by_contig_) {
-    auto& indices = pair.second;
-    std::sort(indices.begin(), indices.end(),
-        [this](size_t index_a, size_t index_b) {
-          return alignments_[index_a].contig_start < alignments_[index_b].contig_start;
+  // Prefix sums, then fill in store order
+  vector<vector<uint32_t>> next(contigs_.size());
+  for (size_t c = 0; c < contigs_.size(); ++c) {
+    auto& index = alignment_index_by_mutation_[c];
+    for (size_t m = 1; m < index.offsets.size(); ++m) {
+      index.offsets[m] += index.offsets[m - 1];
+    }
+    index.alignment_indices.resize(index.offsets.back());
+    next[c].assign(index.offsets.begin(), index.offsets.end() - 1);
+  }
+  for (size_t i = 0; i < alignments_.size(); ++i) {
+    const auto& alignment = alignments_[i];
+    auto& index = alignment_index_by_mutation_[alignment.contig_index];
+    for (uint32_t mutation_index : alignment.mutations) {
+      index.alignment_indices[next[alignment.contig_index][mutation_index]++] = i;
+    }
+  }
+}
+
+void AlignmentStore::build_mutation_position_index()
+{
+  mutation_index_by_position_.assign(contigs_.size(), vector<uint32_t>());
+  for (const auto& pair : mutations_) {
+    const auto& mutations = pair.second;
+    massert(pair.first < contigs_.size(), "mutation table references unknown contig index %u", pair.first);
+    auto& order = mutation_index_by_position_[pair.first];
+    order.resize(mutations.size());
+    for (uint32_t i = 0; i < mutations.size(); ++i) {
+      order[i] = i;
+    }
+    // Sort by position, ties keep table order
+    std::stable_sort(order.begin(), order.end(),
+        [&mutations](uint32_t a, uint32_t b) {
+          return mutations[a].position < mutations[b].position;
         });
   }
+}
+
+void AlignmentStore::build_allele_counts()
+{
+  allele_counts_by_contig_.assign(contigs_.size(), MutationAlleleCounts());
+
+  // Support: alignments carrying each mutation
+  for (size_t c = 0; c < contigs_.size(); ++c) {
+    size_t num_mutations = get_contig_mutations(c).size();
+    allele_counts_by_contig_[c].support.assign(num_mutations, 0);
+    allele_counts_by_contig_[c].coverage.assign(num_mutations, 0);
+  }
+  for (const auto& alignment : alignments_) {
+    auto& support = allele_counts_by_contig_[alignment.contig_index].support;
+    for (uint32_t mutation_index : alignment.mutations) {
+      support[mutation_index]++;
+    }
+  }
+
+  // Coverage: alignments with start <= position < end, that is the number of
+  // starts at or before the position minus the number of ends at or before it
+  vector<uint32_t> starts, ends;
+  for (const auto& pair : mutations_) {
+    const auto& order = alignment_index_by_contig_[pair.first].order;
+    starts.resize(order.size());
+    ends.resize(order.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+      starts[i] = alignments_[order[i]].contig_start;
+      ends[i] = alignments_[order[i]].contig_end;
+    }
+    // starts are already sorted by the overlap index
+    std::sort(ends.begin(), ends.end());
+
+    auto& coverage = allele_counts_by_contig_[pair.first].coverage;
+    for (size_t m = 0; m < pair.second.size(); ++m) {
+      uint32_t position = pair.second[m].position;
+      size_t started = std::upper_bound(starts.begin(), starts.end(), position) - starts.begin();
+      size_t ended = std::upper_bound(ends.begin(), ends.end(), position) - ends.begin();
+      coverage[m] = started - ended;
+    }
+  }
+}
+
+void AlignmentStore::build_coverage_tracks()
+{
+  coverage_tracks_.assign(contigs_.size(), CoverageTrack());
+
+  vector<uint32_t> starts, ends;
+  for (size_t c = 0; c < contigs_.size(); ++c) {
+    const auto& order = alignment_index_by_contig_[c].order;
+    starts.resize(order.size());
+    ends.resize(order.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+      starts[i] = alignments_[order[i]].contig_start;
+      ends[i] = alignments_[order[i]].contig_end;
+    }
+    // starts are already sorted by the overlap index
+    std::sort(ends.begin(), ends.end());
+
+    // Merge the sorted starts and ends, opening a run wherever the depth changes
+    auto& track = coverage_tracks_[c];
+    track.run_starts.push_back(0);
+    track.depths.push_back(0);
+    track.bases_before.push_back(0);
+    uint32_t depth = 0;
+    size_t i = 0, j = 0;
+    while (j < ends.size()) {
+      uint32_t position = (i < starts.size() && starts[i] < ends[j]) ? starts[i] : ends[j];
+      while (i < starts.size() && starts[i] == position) {
+        depth++;
+        i++;
+      }
+      while (j < ends.size() && ends[j] == position) {
+        depth--;
+        j++;
+      }
+      if (depth == track.depths.back()) {
+        continue;
+      }
+      if (track.run_starts.back() == position) {
+        // only possible at position 0, where the initial empty run is replaced
+        track.depths.back() = depth;
+        continue;
+      }
+      uint64_t run_bases = uint64_t(track.depths.back()) * (position - track.run_starts.back());
+      track.bases_before.push_back(track.bases_before.back() + run_bases);
+      track.run_starts.push_back(position);
+      track.depths.push_back(depth);
+    }
+  }
+}
 
-  std::cout << "max alignment length found: " << max_alignment_length_ << std::endl;
+// A zoom bin without coverage, alignment starts or mutations
+static bool is_empty_zoom_bin(const ZoomBin& bin)
+{
+  if (bin.max_depth > 0 || bin.alignment_starts > 0) {
+    return false;
+  }
+  for (size_t t = 0; t < MUTATION_TYPE_COUNT; ++t) {
+    if (bin.mutation_counts[t] > 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Keep the runs of non-empty bins of a dense zoom level
+static ZoomLevel compress_zoom_level(const vector<ZoomBin>& bins)
+{
+  ZoomLevel level;
+  level.run_offsets.push_back(0);
+  for (size_t i = 0; i < bins.size(); ++i) {
+    if (is_empty_zoom_bin(bins[i])) {
+      continue;
+    }
+    if (i == 0 || is_empty_zoom_bin(bins[i - 1])) {
+      if (!level.bins.empty()) {
+        level.run_offsets.push_back(level.bins.size());
+      }
+      level.run_first_bins.push_back(i);
+    }
+    level.bins.push_back(bins[i]);
+  }
+  if (!level.bins.empty()) {
+    level.run_offsets.push_back(level.bins.size());
+  }
+  return level;
+}
+
+void AlignmentStore::build_zoom_pyramids()
+{
+  zoom_pyramids_.assign(contigs_.size(), ZoomPyramid());
+
+  for (size_t c = 0; c < contigs_.size(); ++c) {
+    uint32_t length = contigs_[c].length;
+    auto& levels = zoom_pyramids_[c].levels;
+
+    // The finest level is summed from the coverage runs, the overlap index
+    // and the mutation table
+    ZoomBin empty = {};
+    empty.min_depth = std::numeric_limits<uint32_t>::max();
+    vector<ZoomBin> bins((size_t(length) + ZOOM_BASE_BINSIZE - 1) / ZOOM_BASE_BINSIZE, empty);
+    for_each_coverage_run(c, 0, length, [&](uint32_t run_start, uint32_t run_end, uint32_t depth) {
+      for (uint32_t pos = run_start; pos < run_end;) {
+        ZoomBin& bin = bins[pos / ZOOM_BASE_BINSIZE];
+        uint32_t bin_end = std::min(uint64_t(pos / ZOOM_BASE_BINSIZE + 1) * ZOOM_BASE_BINSIZE, uint64_t(run_end));
+        bin.sequenced_bases += uint64_t(depth) * (bin_end - pos);
+        bin.depth_sum_squares += uint64_t(depth) * depth * (bin_end - pos);
+        bin.min_depth = std::min(bin.min_depth, depth);
+        bin.max_depth = std::max(bin.max_depth, depth);
+        pos = bin_end;
+      }
+    });
+    for_each_alignment_starting_in(c, 0, length, [&](const Alignment& alignment) {
+      bins[alignment.contig_start / ZOOM_BASE_BINSIZE].alignment_starts++;
+    });
+    for_each_mutation_in_interval(c, 0, length, [&](uint32_t mutation_index, const Mutation& mutation) {
+      bins[mutation.position / ZOOM_BASE_BINSIZE].mutation_counts[size_t(mutation.type)] += get_mutation_support(c, mutation_index);
+    });
+    levels.push_back(compress_zoom_level(bins));
+
+    // Each coarser level merges pairs of bins of the level below
+    while (bins.size() > 1) {
+      const auto& fine = bins;
+      vector<ZoomBin> coarse((fine.size() + 1) / 2);
+      for (size_t i = 0; i < coarse.size(); ++i) {
+        coarse[i] = fine[2 * i];
+        if (2 * i + 1 < fine.size()) {
+          const ZoomBin& right = fine[2 * i + 1];
+          coarse[i].sequenced_bases += right.sequenced_bases;
+          coarse[i].depth_sum_squares += right.depth_sum_squares;
+          coarse[i].alignment_starts += right.alignment_starts;
+          for (size_t t = 0; t < MUTATION_TYPE_COUNT; ++t) {
+            coarse[i].mutation_counts[t] += right.mutation_counts[t];
+          }
+          coarse[i].min_depth = std::min(coarse[i].min_depth, right.min_depth);
+          coarse[i].max_depth = std::max(coarse[i].max_depth, right.max_depth);
+        }
+      }
+      bins = std::move(coarse);
+      levels.push_back(compress_zoom_level(bins));
+    }
+  }
+}
+
+const ZoomBin& AlignmentStore::get_zoom_bin(uint32_t contig_idx, size_t level, uint64_t bin) const
+{
+  static const ZoomBin EMPTY_ZOOM_BIN = {};
+  const ZoomLevel& zoom_level = zoom_pyramids_[contig_idx].levels[level];
+
+  // Last run starting at or before the bin
+  const auto& firsts = zoom_level.run_first_bins;
+  size_t run = std::upper_bound(firsts.begin(), firsts.end(), bin) - firsts.begin();
+  if (run == 0) {
+    return EMPTY_ZOOM_BIN;
+  }
+  run--;
+  uint64_t offset = zoom_level.run_offsets[run] + (bin - firsts[run]);
+  return offset < zoom_level.run_offsets[run + 1] ? zoom_level.bins[offset] : EMPTY_ZOOM_BIN;
+}
+
+size_t AlignmentStore::find_coverage_run(const CoverageTrack& track, uint32_t position) const
+{
+  // run_starts[0] is 0, so the run always exists
+  return std::upper_bound(track.run_starts.begin(), track.run_starts.end(), position) - track.run_starts.begin() - 1;
+}
+
+uint32_t AlignmentStore::get_coverage(uint32_t contig_idx, uint32_t position) const
+{
+  massert(contig_idx < coverage_tracks_.size(), "coverage track missing for contig index %u", contig_idx);
+  const auto& track = coverage_tracks_[contig_idx];
+  return track.depths[find_coverage_run(track, position)];
+}
+
+uint64_t AlignmentStore::get_sequenced_bases(uint32_t contig_idx, uint32_t start, uint32_t end) const
+{
+  massert(contig_idx < coverage_tracks_.size(), "coverage track missing for contig index %u", contig_idx);
+  if (start >= end) {
+    return 0;
+  }
+  const auto& track = coverage_tracks_[contig_idx];
+
+  // Bases before a position: prefix sum up to its run, plus the part of the run
+  auto bases_before = [&](uint32_t position) {
+    size_t i = find_coverage_run(track, position);
+    return track.bases_before[i] + uint64_t(track.depths[i]) * (position - track.run_starts[i]);
+  };
+  return bases_before(end) - bases_before(start);
+}
+
+// Sections are stored as (tag, payload size, payload), so readers can skip
+// sections they do not know and rebuild the ones that are missing. A tag gets a
+// new version suffix whenever the layout of its payload changes.
+static const string SECTION_ALIGNMENT_INDEX = "alignment_index";
+static const string SECTION_READ_INDEX = "read_index";
+static const string SECTION_MUTATION_INDEX = "mutation_index";
+static const string SECTION_MUTATION_POSITION_INDEX = "mutation_position_index";
+static const string SECTION_ALLELE_COUNTS = "allele_counts";
+static const string SECTION_COVERAGE_TRACK = "coverage_track";
+static const string SECTION_ZOOM_PYRAMID = "zoom_pyramid_v3";
+
+// Helper function to write a length-prefixed array to binary file
+template <typename T>
+static void write_vector(std::ofstream& file, const vector<T>& values)
+{
+  size_t n = values.size();
+  file.write(reinterpret_cast<const char*>(&n), sizeof(n));
+  file.write(reinterpret_cast<const char*>(values.data()), n * sizeof(T));
+}
+
+// Write a section header, returning the offset of its payload size field
+static std::streampos begin_section(std::ofstream& file, const string& tag)
+{
+  write_string(file, tag);
+  std::streampos size_pos = file.tellp();
+  size_t payload_size = 0;
+  file.write(reinterpret_cast<const char*>(&payload_size), sizeof(payload_size));
+  return size_pos;
+}
+
+// Patch the payload size of a section once its payload was written
+static void end_section(std::ofstream& file, std::streampos size_pos)
+{
+  std::streampos end_pos = file.tellp();
+  size_t payload_size = end_pos - size_pos - std::streamoff(sizeof(size_t));
+  file.seekp(size_pos);
+  file.write(reinterpret_cast<const char*>(&payload_size), sizeof(payload_size));
+  file.seekp(end_pos);
+}
+
+void AlignmentStore::save_sections(std::ofstream& file) const
+{
+  size_t num_sections = 7;
+  file.write(reinterpret_cast<const char*>(&num_sections), sizeof(num_sections));
+
+  // Per-contig overlap index
+  std::streampos pos = begin_section(file, SECTION_ALIGNMENT_INDEX);
+  for (const auto& index : alignment_index_by_contig_) {
+    write_vector(file, index.order);
+    write_vector(file, index.max_end);
+  }
+  end_section(file, pos);
+
+  // Read to alignments index
+  pos = begin_section(file, SECTION_READ_INDEX);
+  write_vector(file, read_alignment_offsets_);
+  write_vector(file, alignment_index_by_read_);
+  end_section(file, pos);
+
+  // Mutation to alignments index
+  pos = begin_section(file, SECTION_MUTATION_INDEX);
+  for (const auto& index : alignment_index_by_mutation_) {
+    write_vector(file, index.offsets);
+    write_vector(file, index.alignment_indices);
+  }
+  end_section(file, pos);
+
+  // Position index over the mutation tables
+  pos = begin_section(file, SECTION_MUTATION_POSITION_INDEX);
+  for (const auto& order : mutation_index_by_position_) {
+    write_vector(file, order);
+  }
+  end_section(file, pos);
+
+  // Precomputed allele counts of the mutation tables
+  pos = begin_section(file, SECTION_ALLELE_COUNTS);
+  for (const auto& counts : allele_counts_by_contig_) {
+    write_vector(file, counts.support);
+    write_vector(file, counts.coverage);
+  }
+  end_section(file, pos);
+
+  // Run-length encoded coverage tracks
+  pos = begin_section(file, SECTION_COVERAGE_TRACK);
+  for (const auto& track : coverage_tracks_) {
+    write_vector(file, track.run_starts);
+    write_vector(file, track.depths);
+    write_vector(file, track.bases_before);
+  }
+  end_section(file, pos);
+
+  pos = begin_section(file, SECTION_ZOOM_PYRAMID);
+  for (const auto& pyramid : zoom_pyramids_) {
+    size_t num_levels = pyramid.levels.size();
+    file.write(reinterpret_cast<const char*>(&num_levels), sizeof(num_levels));
+    for (const auto& level : pyramid.levels) {
+      write_vector(file, level.run_first_bins);
+      write_vector(file, level.run_offsets);
+      write_vector(file, level.bins);
+    }
+  }
+  end_section(file, pos);
+}
+
+// Offsets of a grouped index: start at 0, non-decreasing, and end at the number of entries
+static void check_offsets(const vector<uint32_t>& offsets, size_t num_groups, size_t num_entries)
+{
+  massert(offsets.size() == num_groups + 1, "offsets cover %zu groups, expected %zu", offsets.size() - 1, num_groups);
+  massert(offsets.front() == 0 && offsets.back() == num_entries, "offsets do not span %zu entries", num_entries);
+  for (size_t i = 1; i < offsets.size(); ++i) {
+    massert(offsets[i - 1] <= offsets[i], "decreasing offsets at %zu", i);
+  }
+}
+
+// Every value must be a valid index into an array of the given size
+static void check_indices(const vector<uint32_t>& indices, size_t size)
+{
+  for (uint32_t index : indices) {
+    massert(index < size, "index %u out of range (size %zu)", index, size);
+  }
+}
+
+void AlignmentStore::load_sections(std::ifstream& file)
+{
+  // Files written before sections were introduced end after the alignments
+  std::streampos sections_start = file.tellg();
+  file.seekg(0, ios::end);
+  std::streampos file_end = file.tellg();
+  if (sections_start == file_end) {
+    return;
+  }
+  file.seekg(sections_start);
+
+  size_t num_sections;
+  vector<char> payload;
+  try {
+    read_value(file, num_sections);
+  } catch (const std::runtime_error& e) {
+    std::cerr << "warning: truncated index sections, rebuilding them (" << e.what() << ")" << std::endl;
+    return;
+  }
+  for (size_t s = 0; s < num_sections; ++s) {
+    string tag;
+    try {
+      tag = read_string(file);
+      size_t payload_size;
+      read_value(file, payload_size);
+      massert(payload_size <= size_t(file_end - file.tellg()), "section %s exceeds the file size", tag.c_str());
+      payload.resize(payload_size);
+      file.read(payload.data(), payload_size);
+      massert(file.good(), "unexpected end of file");
+    } catch (const std::exception& e) {
+      // The remaining sections cannot be located, so they are all rebuilt.
+      // A corrupt tag length may also fail to allocate.
+      std::cerr << "warning: truncated index sections, rebuilding them (" << e.what() << ")" << std::endl;
+      return;
+    }
+
+    // Each section is parsed from its own payload. A section that does not
+    // match the store or its payload size is dropped, and load() rebuilds it
+    // like a missing section
+    ByteReader reader(payload.data(), payload.size());
+    try {
+      load_section(tag, reader);
+      massert(reader.at_end(), "%zu unread bytes", reader.remaining());
+    } catch (const std::runtime_error& e) {
+      std::cerr << "warning: invalid section " << tag << ", rebuilding it (" << e.what() << ")" << std::endl;
+      clear_section(tag);
+    }
+  }
+}
+
+void AlignmentStore::load_section(const string& tag, ByteReader& file)
+{
+  if (tag == SECTION_ALIGNMENT_INDEX) {
+    alignment_index_by_contig_.assign(contigs_.size(), ContigAlignmentIndex());
+    size_t num_indexed = 0;
+    for (size_t c = 0; c < contigs_.size(); ++c) {
+      auto& index = alignment_index_by_contig_[c];
+      file.read_vector(index.order);
+      file.read_vector(index.max_end);
+      massert(index.max_end.size() == index.order.size(), "interval tree size mismatch");
+      check_indices(index.order, alignments_.size());
+      for (uint32_t alignment_index : index.order) {
+        massert(alignments_[alignment_index].contig_index == c, "alignment %u indexed under the wrong contig", alignment_index);
+      }
+      num_indexed += index.order.size();
+    }
+    massert(num_indexed == alignments_.size(), "%zu alignments indexed, expected %zu", num_indexed, alignments_.size());
+  } else if (tag == SECTION_READ_INDEX) {
+    file.read_vector(read_alignment_offsets_);
+    file.read_vector(alignment_index_by_read_);
+    check_offsets(read_alignment_offsets_, reads_.size(), alignment_index_by_read_.size());
+    check_indices(alignment_index_by_read_, alignments_.size());
+  } else if (tag == SECTION_MUTATION_INDEX) {
+    alignment_index_by_mutation_.assign(contigs_.size(), MutationAlignmentIndex());
+    for (size_t c = 0; c < contigs_.size(); ++c) {
+      auto& index = alignment_index_by_mutation_[c];
+      file.read_vector(index.offsets);
+      file.read_vector(index.alignment_indices);
+      check_offsets(index.offsets, get_contig_mutations(c).size(), index.alignment_indices.size());
+      check_indices(index.alignment_indices, alignments_.size());
+    }
+  } else if (tag == SECTION_MUTATION_POSITION_INDEX) {
+    mutation_index_by_position_.assign(contigs_.size(), vector<uint32_t>());
+    for (size_t c = 0; c < contigs_.size(); ++c) {
+      auto& order = mutation_index_by_position_[c];
+      file.read_vector(order);
+      size_t num_mutations = get_contig_mutations(c).size();
+      massert(order.size() == num_mutations, "position index size mismatch");
+      check_indices(order, num_mutations);
+    }
+  } else if (tag == SECTION_ALLELE_COUNTS) {
+    allele_counts_by_contig_.assign(contigs_.size(), MutationAlleleCounts());
+    for (size_t c = 0; c < contigs_.size(); ++c) {
+      auto& counts = allele_counts_by_contig_[c];
+      file.read_vector(counts.support);
+      file.read_vector(counts.coverage);
+      size_t num_mutations = get_contig_mutations(c).size();
+      massert(counts.support.size() == num_mutations && counts.coverage.size() == num_mutations, "allele counts size mismatch");
+    }
+  } else if (tag == SECTION_COVERAGE_TRACK) {
+    coverage_tracks_.assign(contigs_.size(), CoverageTrack());
+    for (auto& track : coverage_tracks_) {
+      file.read_vector(track.run_starts);
+      file.read_vector(track.depths);
+      file.read_vector(track.bases_before);
+      massert(!track.run_starts.empty() && track.run_starts[0] == 0, "coverage track does not start at 0");
+      massert(track.depths.size() == track.run_starts.size() && track.bases_before.size() == track.run_starts.size(),
+          "coverage track size mismatch");
+      for (size_t i = 1; i < track.run_starts.size(); ++i) {
+        massert(track.run_starts[i - 1] < track.run_starts[i], "unsorted coverage runs at %zu", i);
+      }
+    }
+  } else if (tag == SECTION_ZOOM_PYRAMID) {
+    zoom_pyramids_.assign(contigs_.size(), ZoomPyramid());
+    for (size_t c = 0; c < contigs_.size(); ++c) {
+      auto& levels = zoom_pyramids_[c].levels;
+      size_t num_levels;
+      file.read(num_levels);
+      // Levels halve the bin count down to a single bin
+      size_t expected_levels = 1;
+      for (uint64_t n = (contigs_[c].length + ZOOM_BASE_BINSIZE - 1) / ZOOM_BASE_BINSIZE; n > 1; n = (n + 1) / 2) {
+        expected_levels++;
+      }
+      massert(num_levels == expected_levels, "%zu zoom levels, expected %zu", num_levels, expected_levels);
+      levels.resize(num_levels);
+      for (size_t k = 0; k < num_levels; ++k) {
+        auto& level = levels[k];
+        file.read_vector(level.run_first_bins);
+        file.read_vector(level.run_offsets);
+        file.read_vector(level.bins);
+        check_offsets(level.run_offsets, level.run_first_bins.size(), level.bins.size());
+        // Runs are non-empty, disjoint, sorted and within the level
+        uint64_t level_binsize = uint64_t(ZOOM_BASE_BINSIZE) << k;
+        uint64_t num_bins = (contigs_[c].length + level_binsize - 1) / level_binsize;
+        uint64_t prev_end = 0;
+        for (size_t r = 0; r < level.run_first_bins.size(); ++r) {
+          uint64_t run_end = uint64_t(level.run_first_bins[r]) + level.run_offsets[r + 1] - level.run_offsets[r];
+          massert(level.run_offsets[r] < level.run_offsets[r + 1] && level.run_first_bins[r] >= prev_end && run_end <= num_bins,
+              "invalid run %zu of zoom level %zu", r, k);
+          prev_end = run_end;
+        }
+      }
+    }
+  } else {
+    file.skip(file.remaining());
+  }
+}
+
+void AlignmentStore::clear_section(const string& tag)
+{
+  if (tag == SECTION_ALIGNMENT_INDEX) {
+    alignment_index_by_contig_.clear();
+  } else if (tag == SECTION_READ_INDEX) {
+    read_alignment_offsets_.clear();
+    alignment_index_by_read_.clear();
+  } else if (tag == SECTION_MUTATION_INDEX) {
+    alignment_index_by_mutation_.clear();
+  } else if (tag == SECTION_MUTATION_POSITION_INDEX) {
+    mutation_index_by_position_.clear();
+  } else if (tag == SECTION_ALLELE_COUNTS) {
+    allele_counts_by_contig_.clear();
+  } else if (tag == SECTION_COVERAGE_TRACK) {
+    coverage_tracks_.clear();
+  } else if (tag == SECTION_ZOOM_PYRAMID) {
+    zoom_pyramids_.clear();
+  }
 }
 
 void AlignmentStore::export_tab_delimited(const string& prefix)
@@ -347,7 +977,7 @@ void AlignmentStore::export_tab_delimited(const string& prefix)
   mutations_out.close();
 }
 
-size_t AlignmentStore::get_read_index(const string& read_id)
+size_t AlignmentStore::get_read_index(const string& read_id) const
 {
   auto it = read_id_to_index.find(read_id);
   massert(it != read_id_to_index.end(), "read not found: %s", read_id.c_str());
@@ -399,45 +1029,22 @@ const string& AlignmentStore::get_contig_id(size_t contig_index) const
   return contigs_[contig_index].id;
 }
 
-std::vector<std::reference_wrapper<const Alignment>> AlignmentStore::get_alignments_in_interval(const Interval& interval) const
+std::vector<Interval> AlignmentStore::get_contig_intervals() const
 {
-  std::vector<std::reference_wrapper<const Alignment>> result;
-
-  auto contig_map_it = contig_id_to_index.find(interval.contig);
-  massert(contig_map_it != contig_id_to_index.end(), "contig not found: %s", interval.contig.c_str());
-  size_t contig_index = contig_map_it->second;
-
-  auto align_map_it = alignment_index_by_contig_.find(contig_index);
-  // It's possible a contig exists but has no alignments, so don't assert here.
-  if (align_map_it == alignment_index_by_contig_.end()) {
-    return result; // No alignments for this contig
-  }
-
-  const auto& indices = align_map_it->second;
-  if (indices.empty()) {
-    return result;
-  }
-
-  uint32_t min_possible_start = (interval.start >= max_alignment_length_) ? (interval.start - max_alignment_length_ + 1) : 0;
-
-  auto it_start = std::lower_bound(indices.begin(), indices.end(), min_possible_start,
-      [this](size_t index, uint32_t min_start) {
-        return alignments_[index].contig_start < min_start;
-      });
-
-  auto it_end = std::upper_bound(indices.begin(), indices.end(), interval.end,
-      [this](uint32_t query_end, size_t index) {
-        return query_end < alignments_[index].contig_start;
-      });
-
-  for (auto it = it_start; it != it_end; ++it) {
-    massert(*it < alignments_.size(), "alignment index out of bounds: %zu", *it);
-    const auto& alignment = alignments_[*it];
-    if (alignment.contig_end >= interval.start) {
-      result.push_back(std::cref(alignment));
-    }
+  std::vector<Interval> intervals;
+  intervals.reserve(contigs_.size());
+  for (const auto& contig : contigs_) {
+    intervals.emplace_back(contig.id, 0, contig.length);
   }
+  return intervals;
+}
 
+std::vector<std::reference_wrapper<const Alignment>> AlignmentStore::get_alignments_in_interval(const Interval& interval) const
+{
+  std::vector<std::reference_wrapper<const Alignment>> result;
+  for_each_alignment_in_interval(interval, [&](const Alignment& alignment) {
+    result.push_back(std::cref(alignment));
+  });
   return result;
 }
 
@@ -1,6 +1,10 @@
 #pragma once
 
 #include "aln_types.h"
+#include "interval_tree.h"
+#include "byte_reader.h"
+#include "utils.h"
+#include <algorithm>
 #include <cstdint>
 #include <fstream>
 #include <functional>
@@ -14,6 +18,68 @@ using std::string;
 using std::unordered_map;
 using std::vector;
 
+// Per-contig overlap index: alignment indices sorted by contig start, and the
+// implicit interval tree built over them (see interval_tree.h)
+struct ContigAlignmentIndex {
+  vector<uint32_t> order;
+  vector<uint32_t> max_end;
+};
+
+// Inverted index of one contig's mutation table: the alignments carrying
+// mutation m are at alignment_indices[offsets[m], offsets[m+1]), in store order
+struct MutationAlignmentIndex {
+  vector<uint32_t> offsets;
+  vector<uint32_t> alignment_indices;
+};
+
+// Allele counts of one contig's mutation table, precomputed at save time:
+// support[m] alignments carry mutation m and coverage[m] alignments cover its position
+struct MutationAlleleCounts {
+  vector<uint32_t> support;
+  vector<uint32_t> coverage;
+};
+
+// Run-length encoded coverage of one contig, precomputed at save time. Depth is
+// depths[i] on [run_starts[i], run_starts[i + 1]), the last run extends to the
+// end of the contig, and bases_before[i] is the sum of the depth before run_starts[i].
+// The first run always starts at 0.
+struct CoverageTrack {
+  vector<uint32_t> run_starts;
+  vector<uint32_t> depths;
+  vector<uint64_t> bases_before;
+};
+
+// Bin size of the finest zoom level, level k has bins of ZOOM_BASE_BINSIZE << k bp
+const uint32_t ZOOM_BASE_BINSIZE = 1024;
+
+// Summary of one bin of a zoom level
+struct ZoomBin {
+  uint64_t sequenced_bases;
+  uint64_t depth_sum_squares; // sum of the squared depth over the bin
+  uint64_t alignment_starts; // alignments starting in the bin
+  // Mutations by MutationType, counted once per alignment carrying them
+  uint64_t mutation_counts[MUTATION_TYPE_COUNT];
+  uint32_t min_depth;
+  uint32_t max_depth;
+};
+
+// One level of a zoom pyramid, bin i spanning [i, i + 1) * (ZOOM_BASE_BINSIZE << level).
+// Only runs of consecutive non-empty bins are stored, run r holding the bins
+// from run_first_bins[r] on at bins[run_offsets[r], run_offsets[r + 1]). Other
+// bins have no coverage, alignment starts or mutations.
+struct ZoomLevel {
+  vector<uint32_t> run_first_bins;
+  vector<uint32_t> run_offsets;
+  vector<ZoomBin> bins;
+};
+
+// Multi-resolution summary of one contig, precomputed at save time. levels[k]
+// holds the bins of ZOOM_BASE_BINSIZE << k bp, up to a level with a single bin.
+// The last bin of a level is truncated at the end of the contig.
+struct ZoomPyramid {
+  vector<ZoomLevel> levels;
+};
+
 class AlignmentStore {
   private:
   std::vector<Contig> contigs_;
@@ -24,10 +90,49 @@ class AlignmentStore {
   unordered_map<string, size_t> contig_id_to_index;
   // Transient map for mutation deduplication during initial build
   std::map<string, uint32_t> mutation_key_to_index_;
-  unordered_map<size_t, vector<size_t>> alignment_index_by_contig_;
-  uint32_t max_alignment_length_ = 0;
+  // Overlap index, indexed by contig
+  vector<ContigAlignmentIndex> alignment_index_by_contig_;
+  // Alignment indices grouped by read (in store order within each read), the
+  // alignments of read r are at [read_alignment_offsets_[r], read_alignment_offsets_[r+1])
+  vector<uint32_t> alignment_index_by_read_;
+  vector<uint32_t> read_alignment_offsets_;
+  // Mutation to alignments index, indexed by contig
+  vector<MutationAlignmentIndex> alignment_index_by_mutation_;
+  // Mutation indices of each contig sorted by position, indexed by contig
+  vector<vector<uint32_t>> mutation_index_by_position_;
+  // Support and coverage of each mutation, indexed by contig
+  vector<MutationAlleleCounts> allele_counts_by_contig_;
+  // Coverage track of each contig, indexed by contig
+  vector<CoverageTrack> coverage_tracks_;
+  // Zoom pyramid of each contig, indexed by contig
+  vector<ZoomPyramid> zoom_pyramids_;
   bool loaded_ = false; // Flag to prevent additions after loading
 
+  // Build the per-contig overlap index
+  void build_alignment_index();
+  // Build the read to alignments index
+  void build_read_index();
+  // Build the mutation to alignments index
+  void build_mutation_index();
+  // Build the position index over the mutation tables
+  void build_mutation_position_index();
+  // Count the support and coverage of each mutation, needs the overlap index
+  void build_allele_counts();
+  // Build the coverage track of each contig, needs the overlap index
+  void build_coverage_tracks();
+  // Build the zoom pyramid of each contig, needs the coverage tracks and allele counts
+  void build_zoom_pyramids();
+  // Index of the coverage run containing a position
+  size_t find_coverage_run(const CoverageTrack& track, uint32_t position) const;
+
+  // Optional sections appended after the alignments
+  void save_sections(std::ofstream& file) const;
+  void load_sections(std::ifstream& file);
+  // Parse and validate one section, throwing if it does not match the store
+  void load_section(const string& tag, ByteReader& file);
+  // Drop a partially loaded section so that it is rebuilt
+  void clear_section(const string& tag);
+
   public:
   // Add methods
   void add_contig(const Contig& contig) { contigs_.push_back(contig); }
@@ -50,6 +155,51 @@ class AlignmentStore {
   // Get a specific mutation object by its contig index and mutation index
   const Mutation& get_mutation(uint32_t contig_idx, uint32_t mutation_idx) const;
 
+  // Get the mutation table of a contig (empty if the contig has no mutations)
+  const std::vector<Mutation>& get_contig_mutations(uint32_t contig_idx) const;
+
+  // Number of alignments carrying a mutation
+  uint32_t get_mutation_support(uint32_t contig_idx, uint32_t mutation_idx) const
+  {
+    return allele_counts_by_contig_[contig_idx].support[mutation_idx];
+  }
+
+  // Number of alignments covering the position of a mutation
+  uint32_t get_mutation_coverage(uint32_t contig_idx, uint32_t mutation_idx) const
+  {
+    return allele_counts_by_contig_[contig_idx].coverage[mutation_idx];
+  }
+
+  // Number of alignments covering a position (start <= position < end)
+  uint32_t get_coverage(uint32_t contig_idx, uint32_t position) const;
+
+  // Sum of the coverage over [start, end), that is the number of aligned
+  // bases falling within the range
+  uint64_t get_sequenced_bases(uint32_t contig_idx, uint32_t start, uint32_t end) const;
+
+  // Calls visit(run_start, run_end, depth) for each coverage run overlapping
+  // [start, end), clipped to the range, in order of position
+  template <typename Visitor>
+  void for_each_coverage_run(uint32_t contig_idx, uint32_t start, uint32_t end, Visitor&& visit) const
+  {
+    if (start >= end) {
+      return;
+    }
+    massert(contig_idx < coverage_tracks_.size(), "coverage track missing for contig index %u", contig_idx);
+    const auto& track = coverage_tracks_[contig_idx];
+    for (size_t i = find_coverage_run(track, start); i < track.run_starts.size() && track.run_starts[i] < end; ++i) {
+      uint32_t run_start = std::max(track.run_starts[i], start);
+      uint32_t run_end = i + 1 < track.run_starts.size() ? std::min(track.run_starts[i + 1], end) : end;
+      visit(run_start, run_end, track.depths[i]);
+    }
+  }
+
+  // Number of zoom levels of a contig
+  size_t get_zoom_level_count(uint32_t contig_idx) const { return zoom_pyramids_[contig_idx].levels.size(); }
+
+  // Bin of a zoom level of a contig, spanning [bin, bin + 1) * (ZOOM_BASE_BINSIZE << level)
+  const ZoomBin& get_zoom_bin(uint32_t contig_idx, size_t level, uint64_t bin) const;
+
   void export_tab_delimited(const string& prefix);
 
   // Save and load methods
@@ -61,14 +211,20 @@ class AlignmentStore {
 
   // Getter methods
   size_t get_alignment_count() const { return alignments_.size(); }
+  size_t get_alignment_index(const Alignment& alignment) const { return &alignment - alignments_.data(); }
   size_t get_read_count() const { return reads_.size(); }
+  size_t get_contig_count() const { return contigs_.size(); }
+  uint32_t get_contig_length(size_t contig_index) const { return contigs_[contig_index].length; }
+
+  // Intervals spanning each contig in full, in contig index order
+  std::vector<Interval> get_contig_intervals() const;
 
   // Add or get read index
   size_t add_or_get_read_index(const string& read_id, uint32_t length);
   size_t add_or_get_contig_index(const string& contig_id, uint32_t length);
 
   // Get read index
-  size_t get_read_index(const string& read_id);
+  size_t get_read_index(const string& read_id) const;
   size_t get_contig_index(const string& contig_id) const;
 
   // Get id by index
@@ -77,4 +233,96 @@ class AlignmentStore {
 
   // New method to get alignments in a specific interval
   std::vector<std::reference_wrapper<const Alignment>> get_alignments_in_interval(const Interval& interval) const;
+
+  // Calls visit(alignment) for each alignment overlapping [start, end] on a
+  // contig, in order of contig start. Hits are streamed straight from the
+  // interval tree, nothing is allocated per query.
+  template <typename Visitor>
+  void for_each_alignment_in_interval(uint32_t contig_index, uint32_t start, uint32_t end, Visitor&& visit) const
+  {
+    massert(contig_index < alignment_index_by_contig_.size(), "alignment index missing for contig index %u", contig_index);
+    const auto& index = alignment_index_by_contig_[contig_index];
+    const auto& order = index.order;
+    itree_query(
+        order.size(), index.max_end.data(),
+        [&](size_t i) { return alignments_[order[i]].contig_start; },
+        [&](size_t i) { return alignments_[order[i]].contig_end; },
+        start, end,
+        [&](size_t i) { visit(alignments_[order[i]]); });
+  }
+
+  // Calls visit(alignment) for each alignment of a contig starting in
+  // [start, end), in order of contig start
+  template <typename Visitor>
+  void for_each_alignment_starting_in(uint32_t contig_index, uint32_t start, uint32_t end, Visitor&& visit) const
+  {
+    massert(contig_index < alignment_index_by_contig_.size(), "alignment index missing for contig index %u", contig_index);
+    const auto& order = alignment_index_by_contig_[contig_index].order;
+    auto it = std::lower_bound(order.begin(), order.end(), start,
+        [&](uint32_t alignment_index, uint32_t position) { return alignments_[alignment_index].contig_start < position; });
+    for (; it != order.end() && alignments_[*it].contig_start < end; ++it) {
+      visit(alignments_[*it]);
+    }
+  }
+
+  // Calls visit(alignment) for each alignment of a contig, in order of contig
+  // start. This is a sequential sweep of the overlap index, no tree lookups.
+  template <typename Visitor>
+  void for_each_alignment_of_contig(uint32_t contig_index, Visitor&& visit) const
+  {
+    massert(contig_index < alignment_index_by_contig_.size(), "alignment index missing for contig index %u", contig_index);
+    for (uint32_t alignment_index : alignment_index_by_contig_[contig_index].order) {
+      visit(alignments_[alignment_index]);
+    }
+  }
+
+  template <typename Visitor>
+  void for_each_alignment_in_interval(const Interval& interval, Visitor&& visit) const
+  {
+    for_each_alignment_in_interval(get_contig_index(interval.contig), interval.start, interval.end, visit);
+  }
+
+  // Calls visit(mutation_index, mutation) for each distinct mutation of a contig
+  // with position in [start, end), in order of position. Only the mutation
+  // table is searched, alignments are not touched.
+  template <typename Visitor>
+  void for_each_mutation_in_interval(uint32_t contig_index, uint32_t start, uint32_t end, Visitor&& visit) const
+  {
+    massert(contig_index < mutation_index_by_position_.size(), "mutation position index missing for contig index %u", contig_index);
+    const auto& order = mutation_index_by_position_[contig_index];
+    if (order.empty()) {
+      return;
+    }
+    const auto& mutations = get_contig_mutations(contig_index);
+    auto by_position = [&](uint32_t mutation_index, uint32_t position) {
+      return mutations[mutation_index].position < position;
+    };
+    auto it = std::lower_bound(order.begin(), order.end(), start, by_position);
+    auto it_end = std::lower_bound(it, order.end(), end, by_position);
+    for (; it != it_end; ++it) {
+      visit(*it, mutations[*it]);
+    }
+  }
+
+  // Calls visit(alignment_index) for each alignment carrying a mutation, in store order
+  template <typename Visitor>
+  void for_each_alignment_with_mutation(uint32_t contig_index, uint32_t mutation_index, Visitor&& visit) const
+  {
+    massert(contig_index < alignment_index_by_mutation_.size(), "mutation index missing for contig index %u", contig_index);
+    const auto& index = alignment_index_by_mutation_[contig_index];
+    massert(mutation_index + 1 < index.offsets.size(), "mutation index %u out of bounds for contig %u", mutation_index, contig_index);
+    for (uint32_t i = index.offsets[mutation_index]; i < index.offsets[mutation_index + 1]; ++i) {
+      visit(static_cast<size_t>(index.alignment_indices[i]));
+    }
+  }
+
+  // Calls visit(alignment_index) for each alignment of a read, in store order
+  template <typename Visitor>
+  void for_each_alignment_of_read(size_t read_index, Visitor&& visit) const
+  {
+    massert(read_index + 1 < read_alignment_offsets_.size(), "read index out of bounds: %zu", read_index);
+    for (uint32_t i = read_alignment_offsets_[read_index]; i < read_alignment_offsets_[read_index + 1]; ++i) {
+      visit(static_cast<size_t>(alignment_index_by_read_[i]));
+    }
+  }
 };
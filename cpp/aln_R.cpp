@@ -1,13 +1,15 @@
 #include "QueryBin.h"
 #include "QueryFull.h"
 #include "QueryPileup.h"
+#include "QueryRead.h"
+#include "QueryVariant.h"
+#include "QueryVariantTable.h"
 #include "alignment_store.h"
 #include "paf_reader.h"
 #include <Rcpp.h>
 #include <sstream>
 #include <stdexcept>
 #include <string>
-#include <unordered_set>
 #include <vector>
 
 using namespace std;
@@ -63,6 +65,47 @@ std::vector<Interval> Rcpp_DataFrame_to_Intervals(DataFrame df)
   return intervals;
 }
 
+// Helper function to convert R DataFrame to C++ std::vector<Variant>
+std::vector<Variant> Rcpp_DataFrame_to_Variants(DataFrame df)
+{
+  if (!df.containsElementNamed("contig")) {
+    stop("Variants dataframe is missing required column: contig");
+  }
+  if (!df.containsElementNamed("position")) {
+    stop("Variants dataframe is missing required column: position");
+  }
+  if (!df.containsElementNamed("variant")) {
+    stop("Variants dataframe is missing required column: variant");
+  }
+
+  CharacterVector contig = df["contig"];
+  IntegerVector position = df["position"]; // Expecting 1-based
+  CharacterVector variant = df["variant"];
+
+  int n = df.nrows();
+  std::vector<Variant> variants;
+  variants.reserve(n);
+
+  for (int i = 0; i < n; ++i) {
+    if (position[i] <= 0) {
+      stop("Variant positions must be positive (1-based). Found %d at row %d", position[i], i + 1);
+    }
+    variants.emplace_back(as<std::string>(contig[i]), position[i] - 1, as<std::string>(variant[i]));
+  }
+  return variants;
+}
+
+// Helper function to turn a list of equal-length columns into a data frame by
+// setting its attributes, rather than through as.data.frame, so character
+// columns are never converted to factors whatever the R version
+DataFrame Rcpp_columns_to_DataFrame(List columns, CharacterVector names, int nrows)
+{
+  columns.attr("names") = names;
+  columns.attr("row.names") = IntegerVector::create(NA_INTEGER, -nrows);
+  columns.attr("class") = "data.frame";
+  return DataFrame(columns);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // QueryByReadIds function
 ////////////////////////////////////////////////////////////////////////////////
@@ -77,25 +120,26 @@ DataFrame aln_alignments_from_read_ids(
     stop("Invalid AlignmentStore pointer provided.");
   }
 
-  // Get reference to the AlignmentStore object (non-const since get_read_index isn't const)
-  AlignmentStore& store = *store_ptr;
-
-  // Get alignments
-  const std::vector<Alignment>& all_alignments = store.get_alignments();
+  // Get reference to the AlignmentStore object
+  const AlignmentStore& store = *store_ptr;
 
-  // Collect read indices
-  std::unordered_set<uint32_t> target_read_indices;
+  // Convert read IDs
+  std::vector<std::string> read_id_vec;
+  read_id_vec.reserve(read_ids.length());
   for (int i = 0; i < read_ids.length(); ++i) {
-    std::string read_id = as<std::string>(read_ids[i]);
-    try {
-      size_t read_index = store.get_read_index(read_id);
-      target_read_indices.insert(read_index);
-    } catch (const std::runtime_error&) {
-      // Read ID not found, just skip it
-      Rcout << "warning: read ID '" << read_id << "' not found, skipping" << std::endl;
-    }
+    read_id_vec.push_back(as<std::string>(read_ids[i]));
+  }
+
+  // Look up alignments through the read index of the store
+  QueryRead queryRead(read_id_vec, store);
+  queryRead.execute();
+  for (const auto& read_id : queryRead.get_missing_read_ids()) {
+    Rcpp::warning("read ID '%s' not found, skipping", read_id);
   }
 
+  // Get the results
+  const std::vector<ReadOutputRow>& results = queryRead.get_output_rows();
+
   // Output vectors for DataFrame
   NumericVector out_aln_idx;
   CharacterVector out_aln_read_id;
@@ -108,23 +152,17 @@ DataFrame aln_alignments_from_read_ids(
   LogicalVector out_aln_is_reverse;
   IntegerVector out_aln_num_mutations;
 
-  // Collect alignments for target reads
-  for (size_t i = 0; i < all_alignments.size(); ++i) {
-    const Alignment& aln = all_alignments[i];
-
-    if (target_read_indices.find(aln.read_index) != target_read_indices.end()) {
-      // This alignment belongs to one of our target reads
-      out_aln_idx.push_back(i);
-      out_aln_read_id.push_back(store.get_read_id(aln.read_index));
-      out_aln_read_length.push_back(store.get_reads()[aln.read_index].length);
-      out_aln_contig_id.push_back(store.get_contig_id(aln.contig_index));
-      out_aln_read_start.push_back(aln.read_start);
-      out_aln_read_end.push_back(aln.read_end);
-      out_aln_contig_start.push_back(aln.contig_start);
-      out_aln_contig_end.push_back(aln.contig_end);
-      out_aln_is_reverse.push_back(aln.is_reverse);
-      out_aln_num_mutations.push_back(aln.mutations.size());
-    }
+  for (const auto& row : results) {
+    out_aln_idx.push_back(static_cast<double>(row.alignment_index));
+    out_aln_read_id.push_back(row.read_id);
+    out_aln_read_length.push_back(row.read_length);
+    out_aln_contig_id.push_back(row.contig_id);
+    out_aln_read_start.push_back(row.read_start);
+    out_aln_read_end.push_back(row.read_end);
+    out_aln_contig_start.push_back(row.contig_start);
+    out_aln_contig_end.push_back(row.contig_end);
+    out_aln_is_reverse.push_back(row.is_reverse);
+    out_aln_num_mutations.push_back(row.num_mutations);
   }
 
   return DataFrame::create(
@@ -141,6 +179,129 @@ DataFrame aln_alignments_from_read_ids(
       Named("stringsAsFactors") = false);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// QueryVariant function
+////////////////////////////////////////////////////////////////////////////////
+
+// [[Rcpp::export]]
+DataFrame aln_query_variants(
+    XPtr<AlignmentStore> store_ptr,
+    DataFrame variants_df)
+{
+  // Validate the external pointer
+  if (!store_ptr) {
+    stop("Invalid AlignmentStore pointer provided.");
+  }
+
+  // Get reference to the AlignmentStore object
+  const AlignmentStore& store = *store_ptr;
+
+  // Convert variants
+  std::vector<Variant> variants = Rcpp_DataFrame_to_Variants(variants_df);
+
+  QueryVariant queryVariant(variants, store);
+
+  // Run the steps
+  queryVariant.execute();
+  for (const auto& variant : queryVariant.get_missing_variants()) {
+    Rcpp::warning("variant %s:%d %s not found, reporting all covering alignments as non-supporting",
+        variant.contig, variant.position + 1, variant.desc);
+  }
+
+  // Get the results
+  const std::vector<VariantOutputRow>& results = queryVariant.get_output_rows();
+
+  // Convert results to R DataFrame
+  CharacterVector out_contig;
+  IntegerVector out_position;
+  CharacterVector out_variant;
+  NumericVector out_aln_idx;
+  CharacterVector out_read_id;
+  LogicalVector out_supporting;
+
+  for (const auto& row : results) {
+    out_contig.push_back(row.contig);
+    out_position.push_back(row.position);
+    out_variant.push_back(row.variant);
+    out_aln_idx.push_back(static_cast<double>(row.alignment_index));
+    out_read_id.push_back(row.read_id);
+    out_supporting.push_back(row.supporting);
+  }
+
+  return DataFrame::create(
+      Named("contig") = out_contig,
+      Named("position") = out_position,
+      Named("variant") = out_variant,
+      Named("alignment_index") = out_aln_idx,
+      Named("read_id") = out_read_id,
+      Named("supporting") = out_supporting,
+      Named("stringsAsFactors") = false);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// QueryVariantTable function
+////////////////////////////////////////////////////////////////////////////////
+
+// [[Rcpp::export]]
+DataFrame aln_query_variant_table(
+    XPtr<AlignmentStore> store_ptr,
+    DataFrame intervals_df)
+{
+  // Validate the external pointer
+  if (!store_ptr) {
+    stop("Invalid AlignmentStore pointer provided.");
+  }
+
+  // Get reference to the AlignmentStore object
+  const AlignmentStore& store = *store_ptr;
+
+  // Convert intervals
+  std::vector<Interval> intervals = Rcpp_DataFrame_to_Intervals(intervals_df);
+
+  QueryVariantTable queryVariantTable(intervals, store);
+
+  // Run the steps
+  queryVariantTable.execute();
+
+  // Get the results
+  const std::vector<VariantTableOutputRow>& results = queryVariantTable.get_output_rows();
+
+  // Convert results to R DataFrame
+  CharacterVector out_contig;
+  IntegerVector out_interval_start;
+  IntegerVector out_interval_end;
+  IntegerVector out_position;
+  CharacterVector out_type;
+  CharacterVector out_variant;
+  IntegerVector out_support;
+  IntegerVector out_coverage;
+  NumericVector out_frequency;
+
+  for (const auto& row : results) {
+    out_contig.push_back(row.contig);
+    out_interval_start.push_back(row.interval_start);
+    out_interval_end.push_back(row.interval_end);
+    out_position.push_back(row.position);
+    out_type.push_back(row.type);
+    out_variant.push_back(row.variant);
+    out_support.push_back(row.support);
+    out_coverage.push_back(row.coverage);
+    out_frequency.push_back(row.frequency);
+  }
+
+  return DataFrame::create(
+      Named("contig") = out_contig,
+      Named("interval_start") = out_interval_start,
+      Named("interval_end") = out_interval_end,
+      Named("position") = out_position,
+      Named("type") = out_type,
+      Named("variant") = out_variant,
+      Named("support") = out_support,
+      Named("coverage") = out_coverage,
+      Named("frequency") = out_frequency,
+      Named("stringsAsFactors") = false);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Load AlignmentStore from file
 ////////////////////////////////////////////////////////////////////////////////
@@ -179,7 +340,11 @@ XPtr<AlignmentStore> aln_load(std::string filepath)
 DataFrame aln_query_bin(
     XPtr<AlignmentStore> store_ptr,
     DataFrame intervals_df,
-    int binsize)
+    int binsize,
+    int zoom_min_binsize = 1024,
+    int hll_precision = 0,
+    int window = 0,
+    int step = 0)
 {
   // Validate the external pointer
   if (!store_ptr) {
@@ -192,7 +357,7 @@ DataFrame aln_query_bin(
   // Convert intervals
   std::vector<Interval> intervals = Rcpp_DataFrame_to_Intervals(intervals_df);
 
-  QueryBin queryBin(intervals, store, binsize);
+  QueryBin queryBin(intervals, store, binsize, zoom_min_binsize, hll_precision, window, step);
 
   // Run the steps
   queryBin.execute();
@@ -205,8 +370,18 @@ DataFrame aln_query_bin(
   IntegerVector out_bin_start;
   IntegerVector out_bin_end;
   IntegerVector out_bin_length;
-  IntegerVector out_sequenced_bp; // Using IntegerVector for R 'integer' type
-  IntegerVector out_mutation_count;
+  // 64-bit counts are returned as R 'numeric', which holds them exactly up to 2^53
+  NumericVector out_sequenced_bp;
+  NumericVector out_mutation_count;
+  IntegerVector out_min_depth;
+  IntegerVector out_max_depth;
+  NumericVector out_mean_depth;
+  NumericVector out_depth_variance;
+  NumericVector out_alignment_starts;
+  NumericVector out_substitution_count;
+  NumericVector out_insertion_count;
+  NumericVector out_deletion_count;
+  NumericVector out_distinct_reads;
 
   for (const auto& row : results) {
     out_contig.push_back(row.contig);
@@ -215,17 +390,40 @@ DataFrame aln_query_bin(
     out_bin_length.push_back(row.bin_length);
     out_sequenced_bp.push_back(row.sequenced_basepairs);
     out_mutation_count.push_back(row.mutation_count);
+    out_min_depth.push_back(row.min_depth);
+    out_max_depth.push_back(row.max_depth);
+    out_mean_depth.push_back(row.mean_depth);
+    out_depth_variance.push_back(row.depth_variance);
+    out_alignment_starts.push_back(row.alignment_starts);
+    out_substitution_count.push_back(row.substitution_count);
+    out_insertion_count.push_back(row.insertion_count);
+    out_deletion_count.push_back(row.deletion_count);
+    out_distinct_reads.push_back(row.distinct_reads);
   }
 
-  return DataFrame::create(
+  DataFrame bins_df = DataFrame::create(
       Named("contig") = out_contig,
       Named("start") = out_bin_start,
       Named("end") = out_bin_end,
       Named("length") = out_bin_length,
       Named("read_count") = out_sequenced_bp,
       Named("mutation_count") = out_mutation_count,
+      Named("min_depth") = out_min_depth,
+      Named("max_depth") = out_max_depth,
+      Named("mean_depth") = out_mean_depth,
+      Named("depth_variance") = out_depth_variance,
+      Named("alignment_starts") = out_alignment_starts,
+      Named("substitution_count") = out_substitution_count,
+      Named("insertion_count") = out_insertion_count,
+      Named("deletion_count") = out_deletion_count,
       Named("stringsAsFactors") = false // Good practice
   );
+
+  // Distinct read estimates are only reported when sketched
+  if (queryBin.has_distinct_reads()) {
+    bins_df["distinct_reads"] = out_distinct_reads;
+  }
+  return bins_df;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -236,7 +434,11 @@ DataFrame aln_query_bin(
 DataFrame aln_query_pileup(
     XPtr<AlignmentStore> store_ptr,
     DataFrame intervals_df,
-    std::string report_mode_str)
+    std::string report_mode_str,
+    int threads = 1,
+    int min_coverage = 0,
+    int min_count = 0,
+    double min_freq = 0)
 {
   // Validate the external pointer
   if (!store_ptr) {
@@ -250,7 +452,18 @@ DataFrame aln_query_pileup(
   std::vector<Interval> intervals = Rcpp_DataFrame_to_Intervals(intervals_df);
 
   PileupReportMode report_mode = string_to_pileup_report_mode(report_mode_str);
-  QueryPileup queryPileup(intervals, store, report_mode);
+  if (threads <= 0) {
+    stop("threads must be a positive integer.");
+  }
+  // Same bounds as the CLI, NA and NaN frequencies are rejected as well
+  if (min_coverage < 0 || min_count < 0 || !(min_freq >= 0)) {
+    stop("min_coverage, min_count and min_freq must not be negative.");
+  }
+  PileupFilter filter;
+  filter.min_coverage = min_coverage;
+  filter.min_count = min_count;
+  filter.min_freq = min_freq;
+  QueryPileup queryPileup(intervals, store, report_mode, 1000000, threads, filter);
 
   // Run the steps
   queryPileup.execute();
@@ -294,7 +507,8 @@ DataFrame aln_query_pileup(
 List aln_query_full(
     XPtr<AlignmentStore> store_ptr,
     DataFrame intervals_df,
-    std::string height_style_str = "by_coord")
+    std::string height_style_str = "by_coord",
+    std::string columns_str = "all")
 {
   // Validate the external pointer
   if (!store_ptr) {
@@ -311,94 +525,178 @@ List aln_query_full(
     stop("Invalid height_style parameter. Must be 'by_coord' or 'by_mutations'.");
   }
 
+  // Parse the selected output columns
+  FullColumns columns;
+  std::string unknown_column;
+  if (!columns.parse(columns_str, unknown_column)) {
+    stop("Invalid column: '%s'.", unknown_column);
+  }
+
   // Get reference to the AlignmentStore object
   const AlignmentStore& store = *store_ptr;
 
   // Convert intervals
   std::vector<Interval> intervals = Rcpp_DataFrame_to_Intervals(intervals_df);
 
-  QueryFull queryFull(intervals, store, height_style);
+  QueryFull queryFull(intervals, store, height_style, columns);
 
   // Run the steps
   queryFull.execute();
 
   // --- Create Alignments DataFrame ---
+  // Only the selected columns are materialized
   const std::vector<FullOutputAlignments>& alignments = queryFull.get_output_alignments();
-  NumericVector out_aln_idx;
-  CharacterVector out_aln_read_id;
-  IntegerVector out_aln_read_length;
-  CharacterVector out_aln_contig_id;
-  IntegerVector out_aln_read_start;
-  IntegerVector out_aln_read_end;
-  IntegerVector out_aln_contig_start;
-  IntegerVector out_aln_contig_end;
-  LogicalVector out_aln_is_reverse;
-  CharacterVector out_aln_cs_tag;
-  IntegerVector out_aln_height;
-  IntegerVector out_aln_num_mutations;
-
-  for (const auto& aln : alignments) {
-    out_aln_idx.push_back(static_cast<double>(aln.alignment_index + 1)); // R numeric can hold uint64_t
-    out_aln_read_id.push_back(aln.read_id);
-    out_aln_read_length.push_back(aln.read_length);
-    out_aln_contig_id.push_back(aln.contig_id);
-    out_aln_read_start.push_back(aln.read_start);
-    out_aln_read_end.push_back(aln.read_end);
-    out_aln_contig_start.push_back(aln.contig_start);
-    out_aln_contig_end.push_back(aln.contig_end);
-    out_aln_is_reverse.push_back(aln.is_reverse);
-    out_aln_cs_tag.push_back(aln.cs_tag);
-    out_aln_height.push_back(aln.height);
-    out_aln_num_mutations.push_back(aln.num_mutations);
-  }
-
-  DataFrame alignments_df = DataFrame::create(
-      Named("alignment_index") = out_aln_idx,
-      Named("read_id") = out_aln_read_id,
-      Named("read_length") = out_aln_read_length,
-      Named("contig_id") = out_aln_contig_id,
-      Named("read_start") = out_aln_read_start,
-      Named("read_end") = out_aln_read_end,
-      Named("contig_start") = out_aln_contig_start,
-      Named("contig_end") = out_aln_contig_end,
-      Named("is_reverse") = out_aln_is_reverse,
-      Named("cs_tag") = out_aln_cs_tag,
-      Named("mutation_count") = out_aln_num_mutations,
-      Named("height") = out_aln_height,
-      Named("stringsAsFactors") = false);
+  List aln_cols;
+  CharacterVector aln_names;
+  for (FullColumn column : columns.select(FULL_ALIGNMENT_COLUMNS)) {
+    size_t n = alignments.size();
+    RObject values;
+    switch (column) {
+    case FullColumn::ALIGNMENT_INDEX: {
+      NumericVector v(n);
+      for (size_t i = 0; i < n; ++i)
+        v[i] = static_cast<double>(alignments[i].alignment_index + 1); // R numeric can hold uint64_t
+      values = v;
+      break;
+    }
+    case FullColumn::READ_ID: {
+      CharacterVector v(n);
+      for (size_t i = 0; i < n; ++i)
+        v[i] = queryFull.get_read_id(alignments[i]);
+      values = v;
+      break;
+    }
+    case FullColumn::CONTIG_ID: {
+      CharacterVector v(n);
+      for (size_t i = 0; i < n; ++i)
+        v[i] = queryFull.get_contig_id(alignments[i]);
+      values = v;
+      break;
+    }
+    case FullColumn::CS_TAG: {
+      CharacterVector v(n);
+      for (size_t i = 0; i < n; ++i)
+        v[i] = queryFull.get_cs_tag(alignments[i]);
+      values = v;
+      break;
+    }
+    case FullColumn::IS_REVERSE: {
+      LogicalVector v(n);
+      for (size_t i = 0; i < n; ++i)
+        v[i] = alignments[i].is_reverse;
+      values = v;
+      break;
+    }
+    default: {
+      IntegerVector v(n);
+      for (size_t i = 0; i < n; ++i) {
+        const auto& aln = alignments[i];
+        switch (column) {
+        case FullColumn::READ_LENGTH:
+          v[i] = aln.read_length;
+          break;
+        case FullColumn::READ_START:
+          v[i] = aln.read_start;
+          break;
+        case FullColumn::READ_END:
+          v[i] = aln.read_end;
+          break;
+        case FullColumn::CONTIG_START:
+          v[i] = aln.contig_start;
+          break;
+        case FullColumn::CONTIG_END:
+          v[i] = aln.contig_end;
+          break;
+        case FullColumn::MUTATION_COUNT:
+          v[i] = aln.num_mutations;
+          break;
+        default:
+          v[i] = aln.height;
+          break;
+        }
+      }
+      values = v;
+      break;
+    }
+    }
+    aln_cols.push_back(values);
+    aln_names.push_back(full_column_name(column));
+  }
+  DataFrame alignments_df = Rcpp_columns_to_DataFrame(aln_cols, aln_names, alignments.size());
 
   // --- Create Mutations DataFrame ---
+  // Mutation columns keep their short R names (type, position, desc)
   const std::vector<FullOutputMutations>& mutations = queryFull.get_output_mutations();
-  NumericVector out_mut_aln_idx;
-  CharacterVector out_mut_read_id;
-  CharacterVector out_mut_contig_id;
-  CharacterVector out_mut_type; // Convert enum to string
-  IntegerVector out_mut_position;
-  CharacterVector out_mut_desc;
-  IntegerVector out_mut_height;
-
-  for (const auto& mut : mutations) {
-    out_mut_aln_idx.push_back(static_cast<double>(mut.alignment_index + 1)); // R numeric can hold uint64_t
-    out_mut_read_id.push_back(mut.read_id);
-    out_mut_contig_id.push_back(mut.contig_id);
-    // Convert MutationType enum to string for R
-    std::stringstream ss;
-    ss << mut.type; // Use the overloaded operator<< from aln_types.h
-    out_mut_type.push_back(ss.str());
-    out_mut_position.push_back(mut.position);
-    out_mut_desc.push_back(mut.desc);
-    out_mut_height.push_back(mut.height);
-  }
-
-  DataFrame mutations_df = DataFrame::create(
-      Named("alignment_index") = out_mut_aln_idx,
-      Named("read_id") = out_mut_read_id,
-      Named("contig_id") = out_mut_contig_id,
-      Named("type") = out_mut_type,
-      Named("position") = out_mut_position,
-      Named("desc") = out_mut_desc,
-      Named("height") = out_mut_height,
-      Named("stringsAsFactors") = false);
+  List mut_cols;
+  CharacterVector mut_names;
+  if (columns.has_mutation_rows()) {
+    for (FullColumn column : columns.select(FULL_MUTATION_COLUMNS)) {
+      size_t n = mutations.size();
+      RObject values;
+      std::string name = full_column_name(column);
+      switch (column) {
+      case FullColumn::ALIGNMENT_INDEX: {
+        NumericVector v(n);
+        for (size_t i = 0; i < n; ++i)
+          v[i] = static_cast<double>(mutations[i].alignment_index + 1); // R numeric can hold uint64_t
+        values = v;
+        break;
+      }
+      case FullColumn::READ_ID: {
+        CharacterVector v(n);
+        for (size_t i = 0; i < n; ++i)
+          v[i] = queryFull.get_read_id(alignments[mutations[i].alignment_index]);
+        values = v;
+        break;
+      }
+      case FullColumn::CONTIG_ID: {
+        CharacterVector v(n);
+        for (size_t i = 0; i < n; ++i)
+          v[i] = queryFull.get_contig_id(alignments[mutations[i].alignment_index]);
+        values = v;
+        break;
+      }
+      case FullColumn::MUTATION_TYPE: {
+        // Convert MutationType enum to string for R
+        CharacterVector v(n);
+        for (size_t i = 0; i < n; ++i) {
+          std::stringstream ss;
+          ss << mutations[i].type; // Use the overloaded operator<< from aln_types.h
+          v[i] = ss.str();
+        }
+        values = v;
+        name = "type";
+        break;
+      }
+      case FullColumn::MUTATION_POSITION: {
+        IntegerVector v(n);
+        for (size_t i = 0; i < n; ++i)
+          v[i] = mutations[i].position;
+        values = v;
+        name = "position";
+        break;
+      }
+      case FullColumn::MUTATION_DESC: {
+        CharacterVector v(n);
+        for (size_t i = 0; i < n; ++i)
+          v[i] = queryFull.get_mutation_desc(mutations[i]);
+        values = v;
+        name = "desc";
+        break;
+      }
+      default: {
+        IntegerVector v(n);
+        for (size_t i = 0; i < n; ++i)
+          v[i] = mutations[i].height;
+        values = v;
+        break;
+      }
+      }
+      mut_cols.push_back(values);
+      mut_names.push_back(name);
+    }
+  }
+  DataFrame mutations_df = Rcpp_columns_to_DataFrame(mut_cols, mut_names, mutations.size());
 
   return List::create(
       Named("alignments") = alignments_df,
@@ -2,6 +2,9 @@
 #include "QueryBin.h"
 #include "QueryFull.h"
 #include "QueryPileup.h"
+#include "QueryRead.h"
+#include "QueryVariant.h"
+#include "QueryVariantTable.h"
 #include "alignment_store.h"
 #include "utils.h"
 #include <iostream>
@@ -24,12 +27,25 @@ HeightStyle string_to_height_style(const std::string& style_str)
 void query_params(const char* name, int argc, char** argv, Parameters& params)
 {
   params.add_parser("ifn_aln", new ParserFilename("input ALN file"), true);
-  params.add_parser("ifn_intervals", new ParserFilename("input table with query contig intervals"), true);
+  params.add_parser("ifn_intervals", new ParserFilename("input table with query contig intervals (full, pileup, bin, variants modes)"), false);
+  params.add_parser("ifn_read_ids", new ParserFilename("input table with query read IDs (read mode)"), false);
+  params.add_parser("ifn_variants", new ParserFilename("input table with query variants (variant mode)"), false);
   params.add_parser("ofn_prefix", new ParserFilename("output tab-delimited table prefix"), true);
-  params.add_parser("mode", new ParserString("query mode (full, pileup, bin)", "full"), true);
+  params.add_parser("mode", new ParserString("query mode (full, pileup, bin, read, variant, variants)", "full"), true);
   params.add_parser("pileup_mode", new ParserString("pileup report mode (all, covered, mutated)", "covered"), false);
+  params.add_parser("pileup_window", new ParserInteger("window size for streaming 'pileup' mode output", 1000000), false);
+  params.add_parser("min_coverage", new ParserInteger("minimal coverage of reported positions in 'pileup' mode", 0), false);
+  params.add_parser("min_count", new ParserInteger("minimal count of reported rows in 'pileup' mode", 0), false);
+  params.add_parser("min_freq", new ParserDouble("minimal frequency (count / coverage) of reported rows in 'pileup' mode", 0), false);
+  params.add_parser("all_contigs", new ParserBoolean("query every contig in full, in place of ifn_intervals (pileup, bin modes)", false), false);
+  params.add_parser("threads", new ParserInteger("number of threads for 'pileup' and 'all_contigs' 'bin' modes", 1), false);
   params.add_parser("binsize", new ParserInteger("bin size for 'bin' mode", 100), false);
+  params.add_parser("zoom_min_binsize", new ParserInteger("smallest bin size answered from the zoom pyramid in 'bin' mode", ZOOM_BASE_BINSIZE), false);
+  params.add_parser("window", new ParserInteger("sliding window length for 'bin' mode, in place of binsize (0: plain bins)", 0), false);
+  params.add_parser("step", new ParserInteger("sliding window step for 'bin' mode", 0), false);
+  params.add_parser("hll_precision", new ParserInteger("precision of the per-bin distinct read sketches in 'bin' mode (0: no sketches)", 0), false);
   params.add_parser("height_style", new ParserString("alignment height style for 'full' mode (by_coord, by_mutations)", "by_coord"), false);
+  params.add_parser("columns", new ParserString("comma-separated output columns for 'full' mode, or 'all'", "all"), false);
 
   if (argc == 1) {
     params.usage(name);
@@ -43,8 +59,55 @@ void query_params(const char* name, int argc, char** argv, Parameters& params)
 
   // Validate mode
   string mode = params.get_string("mode");
-  if (mode != "full" && mode != "pileup" && mode != "bin") {
-    cerr << "error: invalid mode specified: " << mode << ". Must be 'full', 'pileup', or 'bin'." << endl;
+  if (mode != "full" && mode != "pileup" && mode != "bin" && mode != "read" && mode != "variant" && mode != "variants") {
+    cerr << "error: invalid mode specified: " << mode << ". Must be 'full', 'pileup', 'bin', 'read', 'variant' or 'variants'." << endl;
+    exit(1);
+  }
+
+  // Whole contigs can replace the intervals of pileup and bin modes
+  bool all_contigs = params.get_bool("all_contigs");
+  if (all_contigs && mode != "pileup" && mode != "bin") {
+    cerr << "error: all_contigs is only supported for modes 'pileup' and 'bin'." << endl;
+    exit(1);
+  }
+
+  // Each mode needs its input table
+  if (all_contigs) {
+    if (params.is_defined("ifn_intervals")) {
+      cerr << "error: ifn_intervals cannot be combined with all_contigs." << endl;
+      exit(1);
+    }
+  } else if (mode == "read") {
+    if (!params.is_defined("ifn_read_ids")) {
+      cerr << "error: ifn_read_ids must be specified for mode 'read'." << endl;
+      exit(1);
+    }
+  } else if (mode == "variant") {
+    if (!params.is_defined("ifn_variants")) {
+      cerr << "error: ifn_variants must be specified for mode 'variant'." << endl;
+      exit(1);
+    }
+  } else if (!params.is_defined("ifn_intervals")) {
+    cerr << "error: ifn_intervals must be specified for mode '" << mode << "'." << endl;
+    exit(1);
+  }
+
+  // If mode is 'pileup', pileup_window must be positive
+  if (mode == "pileup") {
+    int pileup_window = params.get_int("pileup_window");
+    if (pileup_window <= 0) {
+      cerr << "error: pileup_window must be a positive integer for mode 'pileup'." << endl;
+      exit(1);
+    }
+  }
+
+  if (params.get_int("threads") <= 0) {
+    cerr << "error: threads must be a positive integer." << endl;
+    exit(1);
+  }
+
+  if (params.get_int("min_coverage") < 0 || params.get_int("min_count") < 0 || params.get_double("min_freq") < 0) {
+    cerr << "error: min_coverage, min_count and min_freq must not be negative." << endl;
     exit(1);
   }
 
@@ -55,6 +118,25 @@ void query_params(const char* name, int argc, char** argv, Parameters& params)
       cerr << "error: binsize must be a positive integer for mode 'bin'." << endl;
       exit(1);
     }
+    if (params.get_int("zoom_min_binsize") < 0) {
+      cerr << "error: zoom_min_binsize must not be negative." << endl;
+      exit(1);
+    }
+    int window = params.get_int("window");
+    int step = params.get_int("step");
+    if (window < 0 || (window > 0 && step <= 0) || (window == 0 && step != 0)) {
+      cerr << "error: window must not be negative, and a positive window needs a positive step." << endl;
+      exit(1);
+    }
+    int hll_precision = params.get_int("hll_precision");
+    if (window > 0 && hll_precision != 0) {
+      cerr << "error: hll_precision cannot be combined with window." << endl;
+      exit(1);
+    }
+    if (hll_precision != 0 && (hll_precision < HyperLogLog::MIN_PRECISION || hll_precision > HyperLogLog::MAX_PRECISION)) {
+      cerr << "error: hll_precision must be 0 or between " << HyperLogLog::MIN_PRECISION << " and " << HyperLogLog::MAX_PRECISION << "." << endl;
+      exit(1);
+    }
   }
 
   // Validate height_style if mode is 'full'
@@ -64,6 +146,12 @@ void query_params(const char* name, int argc, char** argv, Parameters& params)
       cerr << "error: invalid height_style specified: " << height_style << ". Must be 'by_coord' or 'by_mutations'." << endl;
       exit(1);
     }
+    FullColumns columns;
+    string unknown;
+    if (!columns.parse(params.get_string("columns"), unknown)) {
+      cerr << "error: invalid column specified: '" << unknown << "'." << endl;
+      exit(1);
+    }
   }
 
   params.print(cout);
@@ -76,50 +164,121 @@ int query_main(const char* name, int argc, char** argv)
 
   string ifn_aln = params.get_string("ifn_aln");
   string ifn_intervals = params.get_string("ifn_intervals");
+  string ifn_read_ids = params.get_string("ifn_read_ids");
+  string ifn_variants = params.get_string("ifn_variants");
   string ofn_prefix = params.get_string("ofn_prefix");
   string mode = params.get_string("mode");
   int binsize = params.get_int("binsize"); // Will be 0 if not specified or mode is not 'bin'
+  int zoom_min_binsize = params.get_int("zoom_min_binsize");
+  int hll_precision = params.get_int("hll_precision");
+  int window = params.get_int("window");
+  int step = params.get_int("step");
+  int pileup_window = params.get_int("pileup_window");
+  int threads = params.get_int("threads");
+  bool all_contigs = params.get_bool("all_contigs");
+
+  PileupFilter pileup_filter;
+  pileup_filter.min_coverage = params.get_int("min_coverage");
+  pileup_filter.min_count = params.get_int("min_count");
+  pileup_filter.min_freq = params.get_double("min_freq");
 
   // Get pileup mode string and convert to enum
   PileupReportMode pileup_mode = string_to_pileup_report_mode(params.get_string("pileup_mode"));
 
   // Get height style and convert to enum
   HeightStyle height_style = string_to_height_style(params.get_string("height_style"));
+  FullColumns full_columns;
+  string unknown_column;
+  full_columns.parse(params.get_string("columns"), unknown_column);
 
   cout << "query command called:" << endl;
   cout << "  ifn_aln: " << ifn_aln << endl;
-  cout << "  ifn_intervals: " << ifn_intervals << endl;
+  if (mode == "read") {
+    cout << "  ifn_read_ids: " << ifn_read_ids << endl;
+  } else if (mode == "variant") {
+    cout << "  ifn_variants: " << ifn_variants << endl;
+  } else if (all_contigs) {
+    cout << "  all_contigs: T" << endl;
+  } else {
+    cout << "  ifn_intervals: " << ifn_intervals << endl;
+  }
   cout << "  ofn_prefix: " << ofn_prefix << endl;
   cout << "  mode: " << mode << endl;
   if (mode == "bin") {
-    cout << "  binsize: " << binsize << endl;
+    if (window > 0) {
+      cout << "  window: " << window << endl;
+      cout << "  step: " << step << endl;
+    } else {
+      cout << "  binsize: " << binsize << endl;
+    }
+    cout << "  zoom_min_binsize: " << zoom_min_binsize << endl;
+    cout << "  hll_precision: " << hll_precision << endl;
+    if (all_contigs) {
+      cout << "  threads: " << threads << endl;
+    }
   }
   if (mode == "pileup") {
     cout << "  pileup_mode: " << params.get_string("pileup_mode") << endl;
+    cout << "  pileup_window: " << pileup_window << endl;
+    cout << "  threads: " << threads << endl;
+    cout << "  min_coverage: " << pileup_filter.min_coverage << endl;
+    cout << "  min_count: " << pileup_filter.min_count << endl;
+    cout << "  min_freq: " << pileup_filter.min_freq << endl;
   }
   if (mode == "full") {
     cout << "  height_style: " << params.get_string("height_style") << endl;
+    cout << "  columns: " << params.get_string("columns") << endl;
   }
 
   vector<Interval> intervals;
-  read_intervals(ifn_intervals, intervals);
-  cout << "read " << intervals.size() << " intervals from " << ifn_intervals << endl;
+  vector<string> read_ids;
+  vector<Variant> variants;
+  if (mode == "read") {
+    read_read_ids(ifn_read_ids, read_ids);
+    cout << "read " << read_ids.size() << " read IDs from " << ifn_read_ids << endl;
+  } else if (mode == "variant") {
+    read_variants(ifn_variants, variants);
+    cout << "read " << variants.size() << " variants from " << ifn_variants << endl;
+  } else if (!all_contigs) {
+    read_intervals(ifn_intervals, intervals);
+    cout << "read " << intervals.size() << " intervals from " << ifn_intervals << endl;
+  }
 
   AlignmentStore store;
   store.load(ifn_aln);
 
+  if (all_contigs) {
+    intervals = store.get_contig_intervals();
+    cout << "querying all " << intervals.size() << " contigs" << endl;
+  }
+
   if (mode == "full") {
-    QueryFull queryFull(intervals, store, height_style);
+    QueryFull queryFull(intervals, store, height_style, full_columns);
     queryFull.execute();
     queryFull.write_to_csv(ofn_prefix);
   } else if (mode == "pileup") {
-    QueryPileup queryPileup(intervals, store, pileup_mode);
-    queryPileup.execute();
-    queryPileup.write_to_csv(ofn_prefix);
+    QueryPileup queryPileup(intervals, store, pileup_mode, pileup_window, threads, pileup_filter);
+    queryPileup.stream_to_csv(ofn_prefix);
   } else if (mode == "bin") {
-    QueryBin queryBin(intervals, store, binsize);
-    queryBin.execute();
+    QueryBin queryBin(intervals, store, binsize, zoom_min_binsize, hll_precision, window, step);
+    if (all_contigs) {
+      queryBin.execute_all_contigs(threads);
+    } else {
+      queryBin.execute();
+    }
     queryBin.write_to_csv(ofn_prefix);
+  } else if (mode == "read") {
+    QueryRead queryRead(read_ids, store);
+    queryRead.execute();
+    queryRead.write_to_csv(ofn_prefix);
+  } else if (mode == "variant") {
+    QueryVariant queryVariant(variants, store);
+    queryVariant.execute();
+    queryVariant.write_to_csv(ofn_prefix);
+  } else if (mode == "variants") {
+    QueryVariantTable queryVariantTable(intervals, store);
+    queryVariantTable.execute();
+    queryVariantTable.write_to_csv(ofn_prefix);
   }
 
   return 0;
@@ -15,6 +15,9 @@ enum class MutationType {
   DELETION // Deletion of bases
 };
 
+// Number of mutation types, for tables indexed by MutationType
+const size_t MUTATION_TYPE_COUNT = 3;
+
 // Add operator<< for MutationType
 inline std::ostream& operator<<(std::ostream& os, const MutationType& type)
 {
@@ -152,3 +155,17 @@ struct Interval {
     return contig + ":" + std::to_string(start) + "-" + std::to_string(end);
   }
 };
+
+// Structure to represent a queried variant
+struct Variant {
+  string contig;
+  uint32_t position; // 0-based
+  string desc; // as reported by Mutation::to_string()
+
+  Variant(const string& contig = "", uint32_t position = 0, const string& desc = "")
+      : contig(contig)
+      , position(position)
+      , desc(desc)
+  {
+  }
+};
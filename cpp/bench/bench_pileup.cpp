@@ -0,0 +1,188 @@
+// Benchmark of the pileup kernels against the generic loop they replaced.
+// The generic loop expands the coverage densely and checks the report mode
+// and the filters at every position. It is kept here, outside the alntools
+// binary, as a reference whose rows must match the kernels exactly.
+//
+// usage: bench_pileup <input.aln> <ofn_prefix> [threads]
+
+#include "QueryPileup.h"
+#include "alignment_store.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+typedef vector<pair<string, int>> VariantCounts;
+
+static bool passes_count_filter(const PileupFilter& filter, int count, int coverage)
+{
+  if (count < filter.min_count) {
+    return false;
+  }
+  if (filter.min_freq > 0 && (coverage == 0 || count < filter.min_freq * coverage)) {
+    return false;
+  }
+  return true;
+}
+
+// Sort by count descending, then by name
+static void sort_variants(VariantCounts& variants)
+{
+  sort(variants.begin(), variants.end(), [](const auto& a, const auto& b) {
+    if (a.second != b.second) {
+      return a.second > b.second;
+    }
+    return a.first < b.first;
+  });
+}
+
+// Rows of [start, end) on a contig, position by position
+static void pileup_window_generic(const AlignmentStore& store, PileupReportMode mode, const PileupFilter& filter,
+    uint32_t contig_index, uint32_t start, uint32_t end, vector<PileupOutputRow>& rows)
+{
+  uint32_t length = end - start;
+  vector<int> coverage(length, 0);
+  store.for_each_coverage_run(contig_index, start, end, [&](uint32_t run_start, uint32_t run_end, uint32_t depth) {
+    fill(coverage.begin() + (run_start - start), coverage.begin() + (run_end - start), int(depth));
+  });
+
+  vector<vector<uint32_t>> position_mutations(length);
+  store.for_each_mutation_in_interval(contig_index, start, end, [&](uint32_t mutation_index, const Mutation& mutation) {
+    if (store.get_mutation_support(contig_index, mutation_index) > 0) {
+      position_mutations[mutation.position - start].push_back(mutation_index);
+    }
+  });
+
+  string contig_id = store.get_contig_id(contig_index);
+  const auto& mutations = store.get_contig_mutations(contig_index);
+  VariantCounts variants;
+  VariantCounts insertions;
+  for (uint32_t offset = 0; offset < length; ++offset) {
+    int position_coverage = coverage[offset];
+    if (mode == PileupReportMode::COVERED && position_coverage == 0) {
+      continue;
+    }
+    if (mode == PileupReportMode::MUTATED && position_mutations[offset].empty()) {
+      continue;
+    }
+    if (position_coverage < filter.min_coverage) {
+      continue;
+    }
+
+    // Substitutions and deletions sum to the coverage with REF, insertions are apart
+    variants.clear();
+    insertions.clear();
+    int total_mutated_count = 0;
+    for (uint32_t mutation_index : position_mutations[offset]) {
+      const Mutation& mutation = mutations[mutation_index];
+      int count = store.get_mutation_support(contig_index, mutation_index);
+      bool is_insertion = mutation.type == MutationType::INSERTION;
+      if (!is_insertion) {
+        total_mutated_count += count;
+      }
+      if (passes_count_filter(filter, count, position_coverage)) {
+        (is_insertion ? insertions : variants).emplace_back(mutation.to_string(), count);
+      }
+    }
+    sort_variants(variants);
+    sort_variants(insertions);
+
+    uint32_t position = start + offset + 1;
+    int cumsum = 0;
+    for (const auto& variant : variants) {
+      cumsum += variant.second;
+      rows.push_back({ contig_id, position, variant.first, variant.second, position_coverage, cumsum });
+    }
+    int ref_count = position_coverage - total_mutated_count;
+    bool report_ref = ref_count > 0 || (mode == PileupReportMode::ALL && position_coverage == 0);
+    if (report_ref && passes_count_filter(filter, ref_count, position_coverage)) {
+      rows.push_back({ contig_id, position, "REF", ref_count, position_coverage, position_coverage });
+    }
+    cumsum = 0;
+    for (const auto& insertion : insertions) {
+      cumsum += insertion.second;
+      rows.push_back({ contig_id, position, insertion.first, insertion.second, position_coverage, cumsum });
+    }
+  }
+}
+
+static void write_rows(ofstream& ofs, const vector<PileupOutputRow>& rows)
+{
+  for (const auto& row : rows) {
+    ofs << row.contig << "\t" << row.position << "\t" << row.variant << "\t"
+        << row.count << "\t" << row.coverage << "\t" << row.cumsum << "\n";
+  }
+}
+
+static bool same_files(const string& a, const string& b)
+{
+  ifstream fa(a, ios::binary);
+  ifstream fb(b, ios::binary);
+  return fa.is_open() && fb.is_open()
+      && equal(istreambuf_iterator<char>(fa), istreambuf_iterator<char>(), istreambuf_iterator<char>(fb), istreambuf_iterator<char>());
+}
+
+int main(int argc, char** argv)
+{
+  if (argc < 3) {
+    cerr << "usage: " << argv[0] << " <input.aln> <ofn_prefix> [threads]" << endl;
+    return 1;
+  }
+  string ofn_prefix = argv[2];
+  int threads = argc > 3 ? atoi(argv[3]) : 1;
+
+  AlignmentStore store;
+  store.load(argv[1]);
+  vector<Interval> intervals = store.get_contig_intervals();
+
+  const uint32_t window_size = 1000000;
+  const pair<string, PileupReportMode> modes[] = {
+    { "all", PileupReportMode::ALL }, { "covered", PileupReportMode::COVERED }, { "mutated", PileupReportMode::MUTATED }
+  };
+  PileupFilter filtered;
+  filtered.min_coverage = 1;
+  filtered.min_count = 1;
+  const pair<string, PileupFilter> filters[] = { { "none", PileupFilter() }, { "min_coverage=1,min_count=1", filtered } };
+
+  // Both sides stream their rows to a table, whole-genome pileups do not fit in memory
+  string generic_fn = ofn_prefix + "_generic_pileup.tsv";
+  string specialized_prefix = ofn_prefix + "_specialized";
+  for (const auto& mode : modes) {
+    for (const auto& filter : filters) {
+      auto t0 = chrono::steady_clock::now();
+      ofstream ofs(generic_fn);
+      ofs << "contig\tposition\tvariant\tcount\tcoverage\tcumsum\n";
+      vector<PileupOutputRow> rows;
+      for (const auto& interval : intervals) {
+        uint32_t contig_index = store.get_contig_index(interval.contig);
+        for (uint32_t start = interval.start; start < interval.end; start += window_size) {
+          rows.clear();
+          pileup_window_generic(store, mode.second, filter.second, contig_index, start, min(interval.end, start + window_size), rows);
+          write_rows(ofs, rows);
+        }
+      }
+      ofs.close();
+      auto t1 = chrono::steady_clock::now();
+
+      QueryPileup query(intervals, store, mode.second, window_size, threads, filter.second);
+      query.stream_to_csv(specialized_prefix);
+      auto t2 = chrono::steady_clock::now();
+
+      cout << "pileup_mode=" << mode.first << " filter=" << filter.first
+           << ": generic " << chrono::duration_cast<chrono::milliseconds>(t1 - t0).count() << " ms"
+           << ", specialized " << chrono::duration_cast<chrono::milliseconds>(t2 - t1).count() << " ms" << endl;
+      if (!same_files(generic_fn, specialized_prefix + "_pileup.tsv")) {
+        cerr << "error: specialized kernel output differs from the generic loop" << endl;
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "utils.h"
+
+using std::string;
+
+// Sequential reader over a byte buffer, with bounds checking
+class ByteReader {
+  private:
+  const char* pos_;
+  const char* end_;
+
+  public:
+  ByteReader(const char* data, size_t size)
+      : pos_(data)
+      , end_(data + size)
+  {
+  }
+
+  size_t remaining() const { return end_ - pos_; }
+  bool at_end() const { return pos_ == end_; }
+
+  void read_bytes(void* dst, size_t len)
+  {
+    massert(len <= remaining(), "unexpected end of data (need %zu bytes, %zu left)", len, remaining());
+    memcpy(dst, pos_, len);
+    pos_ += len;
+  }
+
+  void skip(size_t len)
+  {
+    massert(len <= remaining(), "unexpected end of data (skipping %zu bytes, %zu left)", len, remaining());
+    pos_ += len;
+  }
+
+  template <typename T>
+  void read(T& value) { read_bytes(&value, sizeof(T)); }
+
+  // Reads a length-prefixed array of trivially copyable values
+  template <typename T>
+  void read_vector(std::vector<T>& values)
+  {
+    size_t n;
+    read(n);
+    massert(n <= remaining() / sizeof(T), "array length %zu exceeds remaining data size", n);
+    values.resize(n);
+    read_bytes(values.data(), n * sizeof(T));
+  }
+
+  // Reads a length-prefixed string, as written by write_string
+  string read_string()
+  {
+    size_t len;
+    read(len);
+    massert(len <= remaining(), "string length %zu exceeds remaining data size", len);
+    string str(pos_, len);
+    pos_ += len;
+    return str;
+  }
+};
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// HyperLogLog sketch of a set of 64-bit keys (Flajolet et al. 2007), with
+// 2^precision one-byte registers. The relative error of the estimate is about
+// 1.04 / sqrt(2^precision), e.g. 3.3% at precision 10 (1 KB per sketch).
+class HyperLogLog {
+  private:
+  int precision_;
+  std::vector<uint8_t> registers_;
+
+  // splitmix64 finalizer, spreads consecutive keys such as read indices
+  static uint64_t hash(uint64_t key)
+  {
+    key += 0x9e3779b97f4a7c15ULL;
+    key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    key = (key ^ (key >> 27)) * 0x94d049bb133111ebULL;
+    return key ^ (key >> 31);
+  }
+
+  public:
+  static const int MIN_PRECISION = 4;
+  static const int MAX_PRECISION = 16;
+
+  explicit HyperLogLog(int precision = 10)
+      : precision_(precision)
+      , registers_(size_t(1) << precision, 0)
+  {
+  }
+
+  void add(uint64_t key)
+  {
+    uint64_t h = hash(key);
+    size_t index = h >> (64 - precision_);
+    // rank of the first 1-bit of the remaining bits, a sentinel bit bounds it
+    uint64_t rest = (h << precision_) | (uint64_t(1) << (precision_ - 1));
+    uint8_t rank = __builtin_clzll(rest) + 1;
+    registers_[index] = std::max(registers_[index], rank);
+  }
+
+  // Estimated number of distinct keys added, using linear counting while
+  // empty registers remain and the raw estimate is small
+  double estimate() const
+  {
+    double m = registers_.size();
+    double sum = 0;
+    size_t zeros = 0;
+    for (uint8_t r : registers_) {
+      sum += std::ldexp(1.0, -r);
+      zeros += (r == 0);
+    }
+    double alpha = m >= 128 ? 0.7213 / (1 + 1.079 / m) : (m >= 64 ? 0.709 : (m >= 32 ? 0.697 : 0.673));
+    double raw = alpha * m * m / sum;
+    if (raw <= 2.5 * m && zeros > 0) {
+      return m * std::log(m / zeros);
+    }
+    return raw;
+  }
+};
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Implicit augmented interval tree over an array of intervals sorted by start
+// (the cgranges layout). Element i is a tree node whose level is the number of
+// trailing 1-bits of i, and max_end[i] is the largest end in its subtree, so
+// the tree costs one extra uint32_t per interval and no pointers.
+//
+// Intervals are closed: interval i overlaps the query [qs, qe] iff
+// start(i) <= qe and end(i) >= qs.
+
+// Level of the root node for an array of n intervals (-1 if empty)
+inline int itree_root_level(size_t n)
+{
+  int k = -1;
+  while ((size_t(1) << (k + 1)) <= n) {
+    k++;
+  }
+  return k;
+}
+
+// Compute the subtree max_end array for n intervals sorted by start
+template <typename EndFn>
+void itree_build(size_t n, EndFn end_of, std::vector<uint32_t>& max_end)
+{
+  max_end.assign(n, 0);
+  if (n == 0) {
+    return;
+  }
+
+  // leaves (level 0) are the even positions
+  size_t last_i = 0; // rightmost node at the current level
+  uint32_t last = 0; // max_end of last_i
+  for (size_t i = 0; i < n; i += 2) {
+    last_i = i;
+    last = max_end[i] = end_of(i);
+  }
+
+  // internal nodes, bottom-up
+  for (int k = 1; (size_t(1) << k) <= n; ++k) {
+    size_t x = size_t(1) << (k - 1);
+    size_t i0 = (x << 1) - 1;
+    size_t step = x << 2;
+    for (size_t i = i0; i < n; i += step) {
+      uint32_t e = end_of(i);
+      uint32_t el = max_end[i - x];
+      uint32_t er = (i + x < n) ? max_end[i + x] : last;
+      if (el > e)
+        e = el;
+      if (er > e)
+        e = er;
+      max_end[i] = e;
+    }
+    // move last_i up to its parent
+    last_i = ((last_i >> k) & 1) ? last_i - x : last_i + x;
+    if (last_i < n && max_end[last_i] > last) {
+      last = max_end[last_i];
+    }
+  }
+}
+
+// Visit the positions of all intervals overlapping [qs, qe], in array order
+template <typename StartFn, typename EndFn, typename Visitor>
+void itree_query(size_t n, const uint32_t* max_end, StartFn start_of, EndFn end_of,
+    uint32_t qs, uint32_t qe, Visitor&& visit)
+{
+  if (n == 0) {
+    return;
+  }
+
+  struct Frame {
+    int k; // node level
+    size_t x; // node position
+    bool left_done; // left subtree already pushed
+  };
+  Frame stack[64];
+  int t = 0;
+
+  int root = itree_root_level(n);
+  stack[t++] = { root, (size_t(1) << root) - 1, false };
+
+  while (t > 0) {
+    Frame z = stack[--t];
+    if (z.k <= 3) {
+      // small subtree: scan it linearly
+      size_t i0 = z.x >> z.k << z.k;
+      size_t i1 = i0 + (size_t(1) << (z.k + 1)) - 1;
+      if (i1 > n)
+        i1 = n;
+      for (size_t i = i0; i < i1 && start_of(i) <= qe; ++i) {
+        if (end_of(i) >= qs) {
+          visit(i);
+        }
+      }
+    } else if (!z.left_done) {
+      size_t y = z.x - (size_t(1) << (z.k - 1)); // left child, may lie past n
+      stack[t++] = { z.k, z.x, true };
+      if (y >= n || max_end[y] >= qs) {
+        stack[t++] = { z.k - 1, y, false };
+      }
+    } else if (z.x < n && start_of(z.x) <= qe) {
+      if (end_of(z.x) >= qs) {
+        visit(z.x);
+      }
+      stack[t++] = { z.k - 1, z.x + (size_t(1) << (z.k - 1)), false };
+    }
+  }
+}
@@ -354,6 +354,66 @@ void read_intervals(const std::string& filename,
   file.close();
 }
 
+void read_read_ids(const std::string& filename,
+    std::vector<std::string>& read_ids)
+{
+  std::ifstream file(filename);
+  if (!file.is_open()) {
+    cerr << "error: could not open file " << filename << " for reading" << endl;
+    exit(EXIT_FAILURE);
+  }
+
+  std::string line;
+  if (getline(file, line)) {
+    // Verify header
+    if (line != "read_id") {
+      cerr << "error: invalid header in read ID file. Expected 'read_id'" << endl;
+      exit(EXIT_FAILURE);
+    }
+  }
+  // read
+  while (getline(file, line)) {
+    if (line.empty()) {
+      continue;
+    }
+    read_ids.push_back(line);
+  }
+  file.close();
+}
+
+void read_variants(const std::string& filename,
+    std::vector<Variant>& variants)
+{
+  std::ifstream file(filename);
+  if (!file.is_open()) {
+    cerr << "error: could not open file " << filename << " for reading" << endl;
+    exit(EXIT_FAILURE);
+  }
+
+  std::string line;
+  if (getline(file, line)) {
+    // Verify header
+    if (line != "contig\tposition\tvariant") {
+      cerr << "error: invalid header in variants file. Expected "
+              "'contig\\tposition\\tvariant'"
+           << endl;
+      exit(EXIT_FAILURE);
+    }
+  }
+  // read, converting 1-based positions to 0-based
+  while (getline(file, line)) {
+    std::istringstream iss(line);
+    std::string contig, desc;
+    uint32_t position;
+    if (!(iss >> contig >> position >> desc) || position == 0) {
+      cerr << "error: malformed line in variants file: " << line << endl;
+      exit(EXIT_FAILURE);
+    }
+    variants.emplace_back(contig, position - 1, desc);
+  }
+  file.close();
+}
+
 // Note: Needs update to work with mutation indices and AlignmentStore
 string generate_cs_tag(const Alignment& alignment, const AlignmentStore& store)
 {
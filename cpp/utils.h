@@ -60,4 +60,8 @@ double get_file_size_mb(const std::string& filename);
 
 void read_intervals(const std::string& filename, std::vector<Interval>& intervals);
 
+void read_read_ids(const std::string& filename, std::vector<std::string>& read_ids);
+
+void read_variants(const std::string& filename, std::vector<Variant>& variants);
+
 string generate_cs_tag(const Alignment& alignment, const AlignmentStore& store);
\ No newline at end of file
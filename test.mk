@@ -13,11 +13,21 @@ TEST_OUTPUT_DIR = output
 TEST_INTERVALS_SMALL = examples/intervals_small.txt
 TEST_INTERVALS_LARGE = examples/intervals_large.txt
 
+# read IDs for query_read
+TEST_READ_IDS = examples/read_ids_small.txt
+
+# interval around ctg22561:11203, where one alignment carries an insertion
+# and a substitution at the same position
+TEST_INTERVALS_INS_SUB = examples/intervals_ins_sub.txt
+
+# variants for query_variant, the last row (-T) is deliberately absent from the store
+TEST_VARIANTS = examples/variants_small.txt
+
 # bin size for query_bin
 TEST_BIN_SIZE = 1000
 
 .PHONY: test test_basic test_full test_query_full test_query_bin \
-test_query_pileup test_query_all test_R_all test_R_commands test_R_plot \
+test_query_pileup test_query_pileup_ins_sub test_query_read test_query_variant test_query_variants test_query_all_contigs test_query_windows test_query_full_columns test_query_all bench_pileup test_R_all test_R_commands test_R_plot \
 test_create_dense_paf clean-test test-r-load
 
 ########################################################################################
@@ -71,6 +81,20 @@ test_query_full: $(TARGET)
 	@echo "QUERY FULL completed successfully"
 	@echo "=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-="
 
+# full mode reduced to the columns needed to draw alignment rectangles,
+# skips cs tags and mutation rows
+test_query_full_columns: $(TARGET)
+	@echo "=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-="
+	@echo "running QUERY FULL COLUMNS"
+	$(TARGET) query \
+		-ifn_aln $(TEST_OUTPUT_DIR)/test.aln \
+		-ifn_intervals $(TEST_INTERVALS_LARGE) \
+		-ofn_prefix $(TEST_OUTPUT_DIR)/query_columns \
+		-mode full \
+		-columns contig_id,contig_start,contig_end,is_reverse,height
+	@echo "QUERY FULL COLUMNS completed successfully"
+	@echo "=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-="
+
 test_query_bin: $(TARGET)
 	@echo "=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-="
 	@echo "running QUERY BIN"
@@ -91,11 +115,114 @@ test_query_pileup: $(TARGET)
 		-ifn_intervals $(TEST_INTERVALS_SMALL) \
 		-ofn_prefix $(TEST_OUTPUT_DIR)/query \
 		-mode pileup \
-		-pileup_mode mutated
+		-pileup_mode mutated \
+		-pileup_window 1000 \
+		-threads 2
 	@echo "QUERY PILEUP completed successfully"
 	@echo "=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-="
 
-test_query_all: test_query_full test_query_bin test_query_pileup
+# an alignment is counted once per position, so the counts of each position
+# end at its coverage even where an insertion and a substitution coincide
+test_query_pileup_ins_sub: $(TARGET)
+	@echo "=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-="
+	@echo "running QUERY PILEUP INS SUB"
+	$(TARGET) query \
+		-ifn_aln $(TEST_OUTPUT_DIR)/test.aln \
+		-ifn_intervals $(TEST_INTERVALS_INS_SUB) \
+		-ofn_prefix $(TEST_OUTPUT_DIR)/query_ins_sub \
+		-mode pileup \
+		-pileup_mode all
+	@# substitutions, deletions and REF sum to the coverage at every position, and
+	@# the insertion sharing 11203 with G:A keeps its own row and full support
+	awk -F'\t' 'NR > 1 && $$3 !~ /^\+/ { cov[$$2] = $$5; sum[$$2] = $$6 } \
+		$$2 == 11203 && $$3 == "+TACAGTTTCAA" && $$4 == 1 && $$6 == 1 { ins = 1 } \
+		END { for (p in cov) if (sum[p] != cov[p]) { print "bases do not sum to coverage at " p; bad = 1 } \
+		if (!ins) { print "insertion row missing at 11203"; bad = 1 } exit bad }' \
+		$(TEST_OUTPUT_DIR)/query_ins_sub_pileup.tsv
+	@echo "QUERY PILEUP INS SUB completed successfully"
+	@echo "=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-="
+
+test_query_read: $(TARGET)
+	@echo "=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-="
+	@echo "running QUERY READ"
+	$(TARGET) query \
+		-ifn_aln $(TEST_OUTPUT_DIR)/test.aln \
+		-ifn_read_ids $(TEST_READ_IDS) \
+		-ofn_prefix $(TEST_OUTPUT_DIR)/query \
+		-mode read
+	@echo "QUERY READ completed successfully"
+	@echo "=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-="
+
+test_query_variant: $(TARGET)
+	@echo "=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-="
+	@echo "running QUERY VARIANT"
+	$(TARGET) query \
+		-ifn_aln $(TEST_OUTPUT_DIR)/test.aln \
+		-ifn_variants $(TEST_VARIANTS) \
+		-ofn_prefix $(TEST_OUTPUT_DIR)/query \
+		-mode variant
+	@echo "QUERY VARIANT completed successfully"
+	@echo "=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-="
+
+test_query_variants: $(TARGET)
+	@echo "=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-="
+	@echo "running QUERY VARIANTS"
+	$(TARGET) query \
+		-ifn_aln $(TEST_OUTPUT_DIR)/test.aln \
+		-ifn_intervals $(TEST_INTERVALS_SMALL) \
+		-ofn_prefix $(TEST_OUTPUT_DIR)/query \
+		-mode variants
+	@echo "QUERY VARIANTS completed successfully"
+	@echo "=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-="
+
+test_query_all_contigs: $(TARGET)
+	@echo "=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-="
+	@echo "running QUERY ALL CONTIGS"
+	$(TARGET) query \
+		-ifn_aln $(TEST_OUTPUT_DIR)/test.aln \
+		-all_contigs T \
+		-threads 2 \
+		-ofn_prefix $(TEST_OUTPUT_DIR)/query_all_contigs \
+		-mode bin \
+		-binsize $(TEST_BIN_SIZE) \
+		-hll_precision 10
+	@echo "QUERY ALL CONTIGS completed successfully"
+	@echo "=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-="
+
+test_query_windows: $(TARGET)
+	@echo "=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-="
+	@echo "running QUERY WINDOWS"
+	$(TARGET) query \
+		-ifn_aln $(TEST_OUTPUT_DIR)/test.aln \
+		-ifn_intervals $(TEST_INTERVALS_LARGE) \
+		-ofn_prefix $(TEST_OUTPUT_DIR)/query_windows \
+		-mode bin \
+		-window 1000 \
+		-step 100
+	@echo "QUERY WINDOWS completed successfully"
+	@echo "=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-="
+
+test_query_all: test_query_full test_query_bin test_query_pileup test_query_pileup_ins_sub test_query_read test_query_variant test_query_variants test_query_all_contigs test_query_windows test_query_full_columns
+
+# pileup benchmark, built apart from alntools from its objects but aln_main
+BENCH_PILEUP = $(BIN_DIR)/bench_pileup
+BENCH_OBJS = $(filter-out $(OBJ_DIR)/aln_main.o, $(OBJS)) $(OBJ_DIR)/bench_pileup.o
+
+$(OBJ_DIR)/bench_pileup.o: $(SRC_DIR)/bench/bench_pileup.cpp $(HDRS) | $(OBJ_DIR)
+	$(CXX) $(CXXFLAGS) -I$(SRC_DIR) -c $< -o $@
+
+$(BENCH_PILEUP): $(BENCH_OBJS) | $(BIN_DIR)
+	$(CXX) $(BENCH_OBJS) -o $(BENCH_PILEUP) $(LDFLAGS)
+
+# time the specialized pileup kernels of each report mode against the generic
+# loop, without and with row filters, and check that both give identical
+# output (requires test_basic)
+bench_pileup: $(BENCH_PILEUP)
+	@echo "=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-="
+	@echo "running PILEUP BENCHMARK"
+	$(BENCH_PILEUP) $(TEST_OUTPUT_DIR)/test.aln $(TEST_OUTPUT_DIR)/bench
+	@echo "PILEUP BENCHMARK completed successfully"
+	@echo "=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-="
 
 ########################################################################################
 # Test R interface